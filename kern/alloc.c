@@ -1,9 +1,28 @@
 /**
  * @file alloc.c
  * @brief Dynamic memory allocator
+ *
+ * Blocks are kept in a chain in address order. Free blocks are additionally
+ * kept in segregated free lists ("bins") by size class, so that finding a
+ * block to reuse doesn't require walking the whole chain. Oversized free
+ * blocks are split when reused, and adjacent free blocks are coalesced when
+ * freed so that the heap doesn't fragment permanently. A free block at the
+ * very end of the chain is given back entirely, so the end of the heap can
+ * shrink again.
+ *
+ * Only small allocations live in this heap. Anything of MEM_PAGE_THRESHOLD
+ * bytes or more is passed on to the page allocator (see page.c), which gets
+ * most of the memory, so that large buffers are page aligned and can't
+ * fragment the heap.
+ *
+ * A bitmap alongside the heap has a bit for each ALIGNMENT sized granule,
+ * set if and only if an allocated block's data starts there. This means any
+ * pointer can be checked in constant time, without trusting anything in the
+ * memory it points at.
  */
 
 #include "alloc.h"
+#include "page.h"
 #include "stdlib.h"
 #include "kernel.h"
 #include <export.h>
@@ -11,8 +30,31 @@
 
 static void* mem_start = NULL;
 static mem_block_t* head;
+// the last block in the chain, new blocks are created directly after it
+static mem_block_t* tail;
 static size_t mem_size;
 
+// one bit per granule of the heap, see the top of this file
+static uint32_t* block_map;
+
+// segregated free lists, see MEM_NUM_BINS
+static mem_block_t* bins[MEM_NUM_BINS];
+// bit n is set if and only if bins[n] is non-empty
+static uint32_t bin_map;
+
+// statistics which are kept up to date as memory is allocated and freed. some
+// of the members are instead worked out when they're asked for, see
+// alloc_get_stats
+static struct alloc_stats stats;
+// number of bytes in free blocks in the heap, and number of blocks (used and
+// free) in the heap
+static size_t heap_free_bytes;
+static size_t heap_blocks;
+
+// allocation counts per caller, see alloc_track_callers
+static struct alloc_callsite callsites[MEM_MAX_CALLSITES];
+static int track_callers = 0;
+
 // #define ALLOC_DEBUG
 
 /**
@@ -23,19 +65,65 @@ static size_t mem_size;
  */
 void init_alloc(void* start, size_t size)
 {
+    // make sure everything after the first header ends up aligned
+    size_t misalignment = (uintptr_t)start % ALIGNMENT;
+    if (misalignment) {
+        start += ALIGNMENT - misalignment;
+        size -= ALIGNMENT - misalignment;
+    }
+
+    // keep a part of the memory for the heap, the rest goes to the page
+    // allocator
+    size_t heap_size = size / MEM_HEAP_FRACTION;
+    heap_size -= heap_size % ALIGNMENT;
+    page_init(start + heap_size, size - heap_size);
+    size = heap_size;
+
+    // the block map goes first, covering the rest of the heap
+    size_t map_size = (size / ALIGNMENT + 31) / 32 * sizeof(uint32_t);
+    map_size = (map_size + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1);
+    block_map = start;
+    memset(block_map, 0, map_size);
+    start += map_size;
+    size -= map_size;
+
     mem_start = start;
     mem_size = size;
     head = start;
+    tail = head;
     head->next = NULL;
+    head->prev = NULL;
     head->size = 0;
     head->state = MEM_STATE_USED;
     head->magic = MEM_BLOCK_MAGIC;
     head->flags = MEM_CRITICAL;
+    head->caller = NULL;
+
+    for (int i = 0; i < MEM_NUM_BINS; i++)
+        bins[i] = NULL;
+    bin_map = 0;
+
+    memset(&stats, 0, sizeof(stats));
+    memset(callsites, 0, sizeof(callsites));
+    heap_free_bytes = 0;
+    heap_blocks = 1;
+}
+
+/**
+ * @brief Add another region of free memory, separate from the one the
+ * allocator was initialised with. The memory is used for large allocations.
+ *
+ * @param start the start of contiguous free memory
+ * @param size the number of free bytes following the start
+ */
+void alloc_add_region(void* start, size_t size)
+{
+    page_add_region(start, size);
 }
 
 /*
- * Align the requested size to the alignment boundary. This is useful to
- * increase reuse of blocks which are allocated
+ * Align the requested size to the alignment boundary. This keeps every block
+ * header (and so the data following it) aligned
  */
 static size_t aligned_size(size_t size)
 {
@@ -43,59 +131,225 @@ static size_t aligned_size(size_t size)
     return (size / ALIGNMENT) * ALIGNMENT + ALIGNMENT;
 }
 
-/**
- * @brief Dynamically allocate some memory. The returned pointer may be for a
- * space larger than that which was requested, but it will *always* be at least
- * as large as the space requested.
- *
- * @param size the size to allocate, in bytes
- * @return void* a pointer to the allocated memory
- */
-void* kalloc(size_t size)
+static size_t granule_of(void* ptr)
 {
-    ASSERT(mem_start, "Allocator was used before initialised");
-    size_t allocated_size = aligned_size(size);
+    return (ptr - mem_start) / ALIGNMENT;
+}
 
-    if (allocated_size == 0)
+static void block_map_set(mem_block_t* block)
+{
+    size_t granule = granule_of(block->addr);
+    block_map[granule / 32] |= 1u << (granule % 32);
+}
+
+static void block_map_clear(mem_block_t* block)
+{
+    size_t granule = granule_of((void*)block + sizeof(mem_block_t));
+    block_map[granule / 32] &= ~(1u << (granule % 32));
+}
+
+// whether ptr is the start of an allocated block in the heap
+static int block_map_test(void* ptr)
+{
+    if (ptr < mem_start || ptr >= mem_start + mem_size || (uintptr_t)ptr % ALIGNMENT)
+        return 0;
+
+    size_t granule = granule_of(ptr);
+    return (block_map[granule / 32] >> (granule % 32)) & 1;
+}
+
+static mem_free_links_t* free_links(mem_block_t* block)
+{
+    return (mem_free_links_t*)((void*)block + sizeof(mem_block_t));
+}
+
+// the bin which a free block of the given size belongs in. size must be at
+// least ALIGNMENT bytes
+static int bin_of(size_t size)
+{
+    int bin = 31 - __builtin_clz(size / ALIGNMENT);
+    return MIN(bin, MEM_NUM_BINS - 1);
+}
+
+// the first bin in which every block is guaranteed to be large enough to hold
+// an (aligned) allocation of the given size
+static int bin_for_alloc(size_t size)
+{
+    size_t granules = size / ALIGNMENT;
+    int bin = 31 - __builtin_clz(granules);
+    if (granules & (granules - 1))
+        bin++;
+    return MIN(bin, MEM_NUM_BINS - 1);
+}
+
+static void bin_insert(mem_block_t* block)
+{
+    int bin = bin_of(block->size);
+    mem_free_links_t* links = free_links(block);
+
+    links->prev = NULL;
+    links->next = bins[bin];
+    if (bins[bin])
+        free_links(bins[bin])->prev = block;
+    bins[bin] = block;
+    bin_map |= 1u << bin;
+    heap_free_bytes += block->size;
+}
+
+static void bin_remove(mem_block_t* block)
+{
+    int bin = bin_of(block->size);
+    mem_free_links_t* links = free_links(block);
+
+    if (links->prev)
+        free_links(links->prev)->next = links->next;
+    else
+        bins[bin] = links->next;
+
+    if (links->next)
+        free_links(links->next)->prev = links->prev;
+
+    if (!bins[bin])
+        bin_map &= ~(1u << bin);
+    heap_free_bytes -= block->size;
+}
+
+// absorb the block following this one into it. the following block must not
+// be in any bin
+static void block_merge_next(mem_block_t* block)
+{
+    mem_block_t* next = block->next;
+    ASSERT(next->magic == MEM_BLOCK_MAGIC, "Memory corruption detected, magic value not present");
+
+    block->size += sizeof(mem_block_t) + next->size;
+    block->next = next->next;
+    if (next->next)
+        next->next->prev = block;
+    if (next == tail)
+        tail = block;
+
+    next->magic = 0;
+    heap_blocks--;
+}
+
+// mark a block as free, coalescing it with any free neighbours so that there
+// are never two free blocks next to each other
+static void block_release(mem_block_t* block)
+{
+    block->state = MEM_STATE_FREE;
+    block_map_clear(block);
+
+    if (block->next && block->next->state == MEM_STATE_FREE) {
+        bin_remove(block->next);
+        block_merge_next(block);
+    }
+    if (block->prev->state == MEM_STATE_FREE) {
+        block = block->prev;
+        bin_remove(block);
+        block_merge_next(block);
+    }
+
+    if (block == tail) {
+        // nothing follows this block, so rather than keeping it around give
+        // it back to the unused space at the end of the heap
+        tail = block->prev;
+        tail->next = NULL;
+        block->magic = 0;
+        heap_blocks--;
+    } else {
+        bin_insert(block);
+    }
+}
+
+// split a block so that it is exactly `size` bytes long, releasing the
+// remainder as a new free block. does nothing if the remainder would be too
+// small. the block must not be free
+static void block_split(mem_block_t* block, size_t size)
+{
+    if (block->size < size + MEM_MIN_SPLIT)
+        return;
+
+    mem_block_t* rest = (void*)block + sizeof(mem_block_t) + size;
+    rest->magic = MEM_BLOCK_MAGIC;
+    rest->flags = 0;
+    rest->size = block->size - size - sizeof(mem_block_t);
+    rest->state = MEM_STATE_USED;
+    rest->addr = (void*)rest + sizeof(mem_block_t);
+    rest->caller = NULL;
+    rest->prev = block;
+    rest->next = block->next;
+    if (block->next)
+        block->next->prev = rest;
+    block->next = rest;
+    block->size = size;
+    if (block == tail)
+        tail = rest;
+    heap_blocks++;
+
+    block_release(rest);
+}
+
+// find a free block which can hold an (aligned) allocation of the given size,
+// or NULL if there is no such block and the heap must be extended
+static mem_block_t* bin_find(size_t size)
+{
+    int bin = bin_for_alloc(size);
+    uint32_t candidates = bin_map & ~((1u << bin) - 1);
+    if (!candidates)
         return NULL;
 
-#ifdef ALLOC_DEBUG
-    debugf("Requested allocation of %d bytes (aligned to %d)", size, allocated_size);
-#endif
+    bin = __builtin_ctz(candidates);
+    if (bin < MEM_NUM_BINS - 1)
+        return bins[bin];
 
-    mem_block_t* current;
-    for (current = head; ; current = current->next)
-    {
-        if (current->state == MEM_STATE_FREE && current->size >= allocated_size)
-        {
-            current->state = MEM_STATE_USED;
+    // the last bin is unbounded, so it's the only one we have to search
+    for (mem_block_t* current = bins[bin]; current; current = free_links(current)->next) {
+        if (current->size >= size)
+            return current;
+    }
+    return NULL;
+}
+
+// allocate an (aligned) number of bytes from the heap, extending it if there
+// are no free blocks which are large enough
+static void* heap_alloc(size_t allocated_size)
+{
+    mem_block_t* block = bin_find(allocated_size);
+    if (block) {
+        ASSERT(block->magic == MEM_BLOCK_MAGIC, "Memory corruption detected, magic value not present");
+        bin_remove(block);
+        block->state = MEM_STATE_USED;
+        block_split(block, allocated_size);
 
 #ifdef ALLOC_DEBUG
-            debugf("Reused memory at %08x", (void*)current + sizeof(mem_block_t));
+        debugf("Reused memory at %08x", (void*)block + sizeof(mem_block_t));
 #endif
-            current->addr = (void*)current + sizeof(mem_block_t);
-            current->flags = 0;
-            return current->addr;
-        }
-
-        if (!current->next)
-            break;
+        block->addr = (void*)block + sizeof(mem_block_t);
+        block->flags = 0;
+        block_map_set(block);
+        return block->addr;
     }
+
 #ifdef ALLOC_DEBUG
-    debugf("Magic: %08x", current->magic);
+    debugf("Magic: %08x", tail->magic);
 #endif
-    ASSERT(current->magic == MEM_BLOCK_MAGIC, "Memory corruption detected, magic value not present");
+    ASSERT(tail->magic == MEM_BLOCK_MAGIC, "Memory corruption detected, magic value not present");
 
-    mem_block_t* next = (void*)current + sizeof(mem_block_t) + current->size;
-    ASSERT((void*)next <= mem_start + mem_size, "Out of memory, cannot allocate");
+    mem_block_t* next = (void*)tail + sizeof(mem_block_t) + tail->size;
+    ASSERT((void*)next + sizeof(mem_block_t) + allocated_size <= mem_start + mem_size,
+        "Out of memory, cannot allocate");
 
     next->size = allocated_size;
     next->next = NULL;
+    next->prev = tail;
     next->state = MEM_STATE_USED;
     next->magic = MEM_BLOCK_MAGIC;
     next->flags = 0;
     next->addr = (void*)next + sizeof(mem_block_t);
-    current->next = next;
+    tail->next = next;
+    tail = next;
+    heap_blocks++;
+    block_map_set(next);
 
 #ifdef ALLOC_DEBUG
     debugf("Allocated memory at %08x", (void*)next + sizeof(mem_block_t));
@@ -103,13 +357,114 @@ void* kalloc(size_t size)
 
     return next->addr;
 }
+
+// the number of bytes from the start of the heap to the end of the last block
+static size_t heap_extent()
+{
+    return (void*)tail + sizeof(mem_block_t) + tail->size - mem_start;
+}
+
+// the number of bytes in used blocks in the heap
+static size_t heap_used()
+{
+    return heap_extent() - heap_free_bytes - heap_blocks * sizeof(mem_block_t);
+}
+
+static void stats_update_peak()
+{
+    size_t live = heap_used() + page_used();
+    if (live > stats.peak_bytes)
+        stats.peak_bytes = live;
+}
+
+// the histogram bucket for an allocation of the given size
+static int histogram_bucket(size_t size)
+{
+    int bucket = 0;
+    while (bucket < MEM_HIST_BUCKETS - 1 && size > (16u << bucket))
+        bucket++;
+    return bucket;
+}
+
+static void callsite_note(void* caller, size_t size)
+{
+    for (int i = 0; i < MEM_MAX_CALLSITES; i++) {
+        if (!callsites[i].caller)
+            callsites[i].caller = caller;
+
+        if (callsites[i].caller == caller) {
+            callsites[i].allocs++;
+            callsites[i].bytes += size;
+            return;
+        }
+    }
+    stats.untracked_allocs++;
+}
+
+// allocate memory on behalf of caller, keeping the statistics up to date
+static void* alloc_from(size_t size, void* caller)
+{
+    ASSERT(mem_start, "Allocator was used before initialised");
+    size_t allocated_size = aligned_size(size);
+
+    if (allocated_size == 0)
+        return NULL;
+
+#ifdef ALLOC_DEBUG
+    debugf("Requested allocation of %d bytes (aligned to %d)", size, allocated_size);
+#endif
+
+    void* ptr;
+    if (allocated_size >= MEM_PAGE_THRESHOLD) {
+        ptr = page_alloc(allocated_size);
+        ASSERT(ptr, "Out of memory, cannot allocate");
+    } else {
+        ptr = heap_alloc(allocated_size);
+        ((mem_block_t*)(ptr - sizeof(mem_block_t)))->caller = caller;
+    }
+
+    stats.total_allocs++;
+    stats.histogram[histogram_bucket(size)]++;
+    if (track_callers)
+        callsite_note(caller, size);
+    stats_update_peak();
+
+    return ptr;
+}
+
+/**
+ * @brief Dynamically allocate some memory. The returned pointer may be for a
+ * space larger than that which was requested, but it will *always* be at least
+ * as large as the space requested.
+ *
+ * @param size the size to allocate, in bytes
+ * @return void* a pointer to the allocated memory
+ */
+void* kalloc(size_t size)
+{
+    return alloc_from(size, __builtin_return_address(0));
+}
 EXPORT_SYM(kalloc);
 
+// move an allocation to a new allocation of new_size bytes, copying over the
+// first `keep` bytes and freeing the old allocation
+static void* realloc_move(void* ptr, size_t keep, size_t new_size, void* caller)
+{
+    void* new_block = alloc_from(new_size, caller);
+    memcpy(new_block, ptr, keep);
+    kfree(ptr);
+    return new_block;
+}
+
 /**
- * @brief Attempt to resize a dynamically allocated pointer to memory. If the
- * memory allocated is too small to contain the new size, then the requested
- * memory will be copied and the old memory freed.
- * 
+ * @brief Attempt to resize a dynamically allocated pointer to memory.
+ *
+ * Where possible the memory is resized in place: shrinking gives the unused
+ * end of the block back to the heap, and growing extends the block into free
+ * space directly following it. Only if that isn't possible will the memory be
+ * copied to a new allocation and the old memory freed. Blocks of pages are
+ * kept as long as the new size still fits and uses more than half the block.
+ *
  * @param ptr pointer to the memory to be reallocated
  * @param new_size the new size, as the entire size to be used not just the
  * additional size
@@ -117,23 +472,59 @@ EXPORT_SYM(kalloc);
  */
 void* krealloc(void* ptr, size_t new_size)
 {
+    void* caller = __builtin_return_address(0);
     if (!ptr)
-        return kalloc(new_size);
+        return alloc_from(new_size, caller);
+
+    if (page_owns(ptr)) {
+        size_t size = page_block_size(ptr);
+        ASSERT(size, "Tried to realloc invalid address");
+        size_t allocated_size = MAX(aligned_size(new_size), ALIGNMENT);
 
-    ASSERT(ptr >= mem_start && ptr <= mem_start + mem_size, "Tried to realloc invalid address");
+        // keep the same block unless it's outgrown it, or shrunk by so much
+        // that the memory would be better off elsewhere
+        if (allocated_size <= size && allocated_size > size / 2)
+            return ptr;
+
+        return realloc_move(ptr, MIN(size, allocated_size), allocated_size, caller);
+    }
+
+    ASSERT(block_map_test(ptr), "Tried to realloc invalid address");
     mem_block_t* block = ptr - sizeof(mem_block_t);
     ASSERT(block->state == MEM_STATE_USED, "Tried to realloc unused block");
     ASSERT(block->magic == MEM_BLOCK_MAGIC, "Tried to realloc corrupted block");
 
-    if (new_size < block->size) {
-        block->size = new_size;
+    // never shrink to nothing, the block still has to be freed later
+    size_t allocated_size = MAX(aligned_size(new_size), ALIGNMENT);
+
+    if (allocated_size <= block->size) {
+        block_split(block, allocated_size);
         return ptr;
-    } else {
-        void* new_block = kalloc(new_size);
-        memcpy(new_block, ptr, block->size);
-        kfree(ptr);
-        return new_block;
     }
+
+    // too big for the heap now, so move it over to the page allocator
+    if (allocated_size >= MEM_PAGE_THRESHOLD)
+        return realloc_move(ptr, block->size, allocated_size, caller);
+
+    if (block == tail) {
+        // at the end of the heap, so we can just move the end further out
+        ASSERT(ptr + allocated_size <= mem_start + mem_size, "Out of memory, cannot allocate");
+        block->size = allocated_size;
+        stats_update_peak();
+        return ptr;
+    }
+
+    mem_block_t* next = block->next;
+    if (next->state == MEM_STATE_FREE
+            && block->size + sizeof(mem_block_t) + next->size >= allocated_size) {
+        bin_remove(next);
+        block_merge_next(block);
+        block_split(block, allocated_size);
+        stats_update_peak();
+        return ptr;
+    }
+
+    return realloc_move(ptr, block->size, new_size, caller);
 }
 EXPORT_SYM(krealloc);
 
@@ -145,12 +536,85 @@ EXPORT_SYM(krealloc);
  */
 void* kallocz(size_t size)
 {
-    void* data = kalloc(size);
+    void* data = alloc_from(size, __builtin_return_address(0));
     memset(data, 0, size);
     return data;
 }
 EXPORT_SYM(kallocz);
 
+/**
+ * @brief Allocate memory aligned to a boundary larger than ALIGNMENT. The
+ * memory is freed as normal with kfree.
+ *
+ * Alignments larger than PAGE_SIZE are not supported, as the page allocator
+ * only aligns its blocks to pages.
+ *
+ * @param size the size to allocate, in bytes
+ * @param align the alignment, which must be a power of two
+ * @return void* a pointer to the allocated memory, NULL if the alignment is
+ * not supported
+ */
+void* kalloc_aligned(size_t size, size_t align)
+{
+    ASSERT(align && !(align & (align - 1)), "Alignment must be a power of two");
+    void* caller = __builtin_return_address(0);
+    size_t allocated_size = aligned_size(size);
+
+    // pages are always page aligned, so anything going to the page allocator
+    // anyway doesn't need any special treatment
+    if (align <= ALIGNMENT || (align <= PAGE_SIZE && allocated_size >= MEM_PAGE_THRESHOLD))
+        return alloc_from(size, caller);
+
+    if (allocated_size == 0 || align > PAGE_SIZE)
+        return NULL;
+
+    // if the padding below would tip it over into the page allocator, which
+    // has no block headers to move, take a single page from it directly. that
+    // is always page aligned
+    if (allocated_size + align + MEM_MIN_SPLIT >= MEM_PAGE_THRESHOLD)
+        return alloc_from(MEM_PAGE_THRESHOLD, caller);
+
+    // over-allocate by enough that the start can be moved up to the next
+    // boundary, leaving a gap large enough to be released as a block of its own
+    void* ptr = alloc_from(allocated_size + align + MEM_MIN_SPLIT, caller);
+    if (!ptr)
+        return NULL;
+
+    mem_block_t* block = ptr - sizeof(mem_block_t);
+
+    if ((uintptr_t)ptr % align == 0) {
+        block_split(block, allocated_size);
+        return ptr;
+    }
+
+    void* aligned = (void*)(((uintptr_t)ptr + MEM_MIN_SPLIT + align - 1) & ~(uintptr_t)(align - 1));
+    size_t gap = aligned - ptr;
+
+    mem_block_t* moved = aligned - sizeof(mem_block_t);
+    moved->magic = MEM_BLOCK_MAGIC;
+    moved->flags = 0;
+    moved->size = block->size - gap;
+    moved->state = MEM_STATE_USED;
+    moved->addr = aligned;
+    moved->caller = caller;
+    moved->prev = block;
+    moved->next = block->next;
+    if (block->next)
+        block->next->prev = moved;
+    block->next = moved;
+    if (block == tail)
+        tail = moved;
+    heap_blocks++;
+    block_map_set(moved);
+
+    block->size = gap - sizeof(mem_block_t);
+    block_release(block);
+    block_split(moved, allocated_size);
+
+    return aligned;
+}
+EXPORT_SYM(kalloc_aligned);
+
 /**
  * @brief Free allocated memory
  * 
@@ -162,8 +626,15 @@ void kfree(void* ptr)
     debugf("Requested clear at %08x bytes", ptr);
 #endif
 
-    // We should only free addresses which we own
-    ASSERT(ptr >= mem_start && ptr <= mem_start + mem_size, "Tried to free invalid address");
+    stats.total_frees++;
+    if (page_owns(ptr)) {
+        page_free(ptr);
+        return;
+    }
+
+    // We should only free addresses which we own, and which are allocated
+    ASSERT(ptr >= mem_start && ptr < mem_start + mem_size, "Tried to free invalid address");
+    ASSERT(block_map_test(ptr), "Tried to free memory which isn't allocated");
 
     mem_block_t* block = ptr - sizeof(mem_block_t);
 
@@ -171,39 +642,28 @@ void kfree(void* ptr)
     ASSERT(block->state == MEM_STATE_USED, "Tried to free already free memory");
     ASSERT(block->magic == MEM_BLOCK_MAGIC, "Memory corruption detected, magic value not present");
 
-    block->state = MEM_STATE_FREE;
+    block_release(block);
 }
 EXPORT_SYM(kfree);
 
 /**
  * @brief Check the validity of a memory address.
  *
- * The memory check can be performed either by means of a bounds check
- * (quick=1), or by means of a search of the entire chunk chain (quick=0).
- * Caution must be exercised with quick=1, because it could feasibly be fooled
- * into thinking a pointer is valid, when it is not. Conversely, with a system
- * having a large number of allocations, quick=0 can easily become quite slow.
+ * An address is valid if it is the start of memory which is currently
+ * allocated. The check is exact and takes constant time, as it only looks at
+ * the allocator's own records rather than the memory around the address.
  *
  * @param ptr the address to check for validity
- * @param quick whether to perform only a bounds check, or perform an
- * exhaustive search
+ * @param quick unused, kept for compatibility. when this was set only the
+ * block header was checked, as checking exactly meant searching the heap
  * @return int non-zero indicates valid, zero indicates invalid
  */
 int alloc_valid_addr(void* ptr, int quick)
 {
-    if (ptr < mem_start || ptr > mem_start + mem_size) return 0;
-
-    if (quick) {
-        mem_block_t* block = ptr - sizeof(mem_block_t);
-        return block->magic == MEM_BLOCK_MAGIC;
-    }
+    if (page_owns(ptr))
+        return page_block_size(ptr) != 0;
 
-    for (mem_block_t* current = head; current; current = current->next) {
-        if (current->addr == ptr) {
-            return 1;
-        }
-    }
-    return 0;
+    return block_map_test(ptr);
 }
 
 /**
@@ -215,13 +675,8 @@ int alloc_valid_addr(void* ptr, int quick)
  */
 size_t alloc_used(int all)
 {
-    size_t total = 0;
-    for (mem_block_t* current = head; current; current = current->next)
-    {
-        if (current->state != MEM_STATE_FREE || all)
-            total += current->size;
-    }
-    return total;
+    size_t total = all ? heap_used() + heap_free_bytes : heap_used();
+    return total + page_used();
 }
 
 /**
@@ -231,7 +686,104 @@ size_t alloc_used(int all)
  */
 size_t alloc_total()
 {
-    return mem_size;
+    return mem_size + page_total();
+}
+
+// fragmentation of some free memory as a percentage, 0% being all of the
+// free memory in one block
+static int fragmentation(size_t free, size_t largest)
+{
+    if (!free)
+        return 0;
+    // scale down rather than up so this can't overflow
+    size_t percent = free < 100 ? largest * 100 / free : largest / (free / 100);
+    return 100 - MIN((int)percent, 100);
+}
+
+/**
+ * @brief Get statistics about the allocator.
+ *
+ * @param out where to put the statistics
+ */
+void alloc_get_stats(struct alloc_stats* out)
+{
+    memcpy(out, &stats, sizeof(stats));
+
+    out->live_bytes = heap_used() + page_used();
+    out->live_allocs = stats.total_allocs - stats.total_frees;
+    out->heap_free_bytes = heap_free_bytes;
+    out->heap_blocks = heap_blocks;
+    out->page_free_bytes = page_total() - page_used();
+    out->page_largest_free = page_largest_free();
+
+    // the space past the end of the heap is free too, and is as large as a
+    // block in it can be
+    size_t unused = mem_size - heap_extent();
+    size_t largest = unused > sizeof(mem_block_t) ? unused - sizeof(mem_block_t) : 0;
+    out->heap_free_bytes += largest;
+
+    // only the largest non-empty bin can have the largest block
+    if (bin_map) {
+        int bin = 31 - __builtin_clz(bin_map);
+        for (mem_block_t* current = bins[bin]; current; current = free_links(current)->next)
+            largest = MAX(largest, current->size);
+    }
+    out->heap_largest_free = largest;
+
+    out->heap_fragmentation = fragmentation(out->heap_free_bytes, out->heap_largest_free);
+    out->page_fragmentation = fragmentation(out->page_free_bytes, out->page_largest_free);
+}
+
+/**
+ * @brief Turn counting allocations by their caller on or off. Counts are kept
+ * for up to MEM_MAX_CALLSITES different callers.
+ *
+ * @param enable non-zero to start counting, zero to stop
+ */
+void alloc_track_callers(int enable)
+{
+    track_callers = enable;
+}
+
+/**
+ * @brief Get the allocation counts for each caller, collected while
+ * alloc_track_callers is enabled.
+ *
+ * @param count set to the number of callers
+ * @return const struct alloc_callsite* the counts for each caller
+ */
+const struct alloc_callsite* alloc_callsites(size_t* count)
+{
+    size_t n = 0;
+    while (n < MEM_MAX_CALLSITES && callsites[n].caller)
+        n++;
+    *count = n;
+    return callsites;
+}
+
+/**
+ * @brief Dump allocator statistics to the debug output in a compact form
+ */
+void kdumpstats()
+{
+    struct alloc_stats s;
+    alloc_get_stats(&s);
+
+    debugf("heap: live=%d peak=%d allocs=%d frees=%d blocks=%d",
+        s.live_bytes, s.peak_bytes, s.total_allocs, s.total_frees, s.heap_blocks);
+    debugf("free: heap=%d/%d pages=%d/%d (total/largest)",
+        s.heap_free_bytes, s.heap_largest_free, s.page_free_bytes, s.page_largest_free);
+
+    char line[MEM_HIST_BUCKETS * 11 + 1];
+    int offset = 0;
+    for (int i = 0; i < MEM_HIST_BUCKETS; i++)
+        offset += snprintf(line + offset, sizeof(line) - offset, " %d", s.histogram[i]);
+    debugf("hist:%s", line);
+
+    size_t count;
+    const struct alloc_callsite* sites = alloc_callsites(&count);
+    for (size_t i = 0; i < count; i++)
+        debugf("site %08x: allocs=%d bytes=%d", sites[i].caller, sites[i].allocs, sites[i].bytes);
 }
 
 /**
@@ -241,7 +793,12 @@ size_t alloc_total()
  */
 void kmmcritical(void* ptr)
 {
-    ASSERT(ptr >= mem_start && ptr <= mem_start + mem_size, "Tried mark as critical an invalid address");
+    if (page_owns(ptr)) {
+        page_mark_critical(ptr);
+        return;
+    }
+
+    ASSERT(block_map_test(ptr), "Tried mark as critical an invalid address");
     mem_block_t* block = ptr - sizeof(mem_block_t);
     block->flags |= MEM_CRITICAL;
 }
@@ -255,10 +812,13 @@ void kdumpmm()
     int blk = 0;
     for (mem_block_t* current = head; current; current = current->next, blk++)
     {
-        debugf("block %04d, size: %d bytes, at: %08x", 
-            blk, 
-            current->size, 
-            (void*)current + sizeof(mem_block_t)
+        debugf("block %04d, size: %d bytes, at: %08x, %s, by: %08x",
+            blk,
+            current->size,
+            (void*)current + sizeof(mem_block_t),
+            current->state == MEM_STATE_FREE ? "free" : "used",
+            current->caller
         );
     }
+    page_dump();
 }
@@ -3,9 +3,52 @@
 #include <stddef.h>
 #include <stdint.h>
 
+// Number of buckets in the allocation size histogram. Bucket n counts
+// allocations of up to 16 << n bytes, with the last bucket also counting
+// everything larger
+#define MEM_HIST_BUCKETS        18
+// The most distinct callers that are counted, see alloc_track_callers
+#define MEM_MAX_CALLSITES       32
+
+struct alloc_stats {
+    // bytes in allocated blocks, both in the heap and the page allocator
+    size_t live_bytes;
+    size_t peak_bytes;
+    size_t live_allocs;
+    size_t total_allocs;
+    size_t total_frees;
+    // free bytes in the heap (including the unused space at its end), the
+    // largest single allocation that could be made from them, and the number
+    // of blocks (used and free) making up the heap
+    size_t heap_free_bytes;
+    size_t heap_largest_free;
+    size_t heap_blocks;
+    // free bytes in the page allocator, and the largest free block
+    size_t page_free_bytes;
+    size_t page_largest_free;
+    // how fragmented the free memory is, as a percentage. 0% means all of it
+    // is in one block
+    int heap_fragmentation;
+    int page_fragmentation;
+    // allocations by requested size, see MEM_HIST_BUCKETS
+    size_t histogram[MEM_HIST_BUCKETS];
+    // allocations which weren't counted for a caller as too many callers had
+    // already been seen
+    size_t untracked_allocs;
+};
+
+struct alloc_callsite {
+    // the return address of the call to the allocator
+    void* caller;
+    size_t allocs;
+    size_t bytes;
+};
+
 void init_alloc(void* start, size_t size);
+void alloc_add_region(void* start, size_t size);
 void* kalloc(size_t size);
 void* kallocz(size_t size);
+void* kalloc_aligned(size_t size, size_t align);
 void kfree(void* ptr);
 void kdumpmm();
 void kmmcritical(void* ptr);
@@ -13,9 +56,24 @@ int alloc_valid_addr(void* ptr, int quick);
 void* krealloc(void* ptr, size_t new_size);
 size_t alloc_total();
 size_t alloc_used(int all);
+void alloc_get_stats(struct alloc_stats* out);
+void alloc_track_callers(int enable);
+const struct alloc_callsite* alloc_callsites(size_t* count);
+void kdumpstats();
 
 #define MEM_BLOCK_MAGIC         0xbadbaddd
-#define ALIGNMENT       64
+#define ALIGNMENT       16
+
+// Allocations of at least this many bytes come from the page allocator
+// rather than the heap
+#define MEM_PAGE_THRESHOLD      4096
+// The heap is given 1/MEM_HEAP_FRACTION of memory, the page allocator the rest
+#define MEM_HEAP_FRACTION       4
+
+// Number of segregated free lists. Bin n holds free blocks of between 2^n and
+// 2^(n+1) - 1 granules (of ALIGNMENT bytes), with the final bin also holding
+// everything larger than that.
+#define MEM_NUM_BINS    24
 
 enum mem_block_state {
     MEM_STATE_USED,
@@ -28,8 +86,23 @@ typedef struct mem_block {
     size_t size;
     enum mem_block_state state;
     void* addr;
+    // neighbouring blocks in the chain, which is kept in address order
+    struct mem_block* next;
+    struct mem_block* prev;
+    // where the block was allocated from, for debugging
+    void* caller;
+} __attribute__((aligned(ALIGNMENT))) mem_block_t;
+
+// The smallest amount of space worth splitting off a free block, anything
+// smaller is left attached to the block it would have been split from
+#define MEM_MIN_SPLIT   (sizeof(mem_block_t) + ALIGNMENT)
+
+// Links for the segregated free lists. These are only valid while a block is
+// free, at which point they occupy the start of its (otherwise unused) data
+typedef struct mem_free_links {
     struct mem_block* next;
-} mem_block_t;
+    struct mem_block* prev;
+} mem_free_links_t;
 
 enum mem_flags {
     MEM_NONE = 0,
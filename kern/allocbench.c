@@ -0,0 +1,214 @@
+/**
+ * @file allocbench.c
+ * @brief Allocator benchmark
+ *
+ * Runs a set of reproducible workloads against kalloc, kfree and krealloc and
+ * reports how long each took, so that changes to the allocator can be compared
+ * with one another. The random workloads always use the same seed, so every
+ * run does exactly the same allocations.
+ */
+
+#include "allocbench.h"
+
+#include <stdint.h>
+#include "stdlib.h"
+#include "alloc.h"
+#include "bench.h"
+
+// default number of allocations live at once in each workload
+#define ALLOCBENCH_DEFAULT_COUNT    2000
+#define ALLOCBENCH_SEED             0x1234
+
+struct allocbench_result {
+    // the number of allocator calls made, and the cycles spent making them
+    uint32_t ops;
+    uint64_t cycles;
+    // fragmentation of the heap at the workload's busiest point
+    int fragmentation;
+};
+
+static int heap_fragmentation()
+{
+    struct alloc_stats stats;
+    alloc_get_stats(&stats);
+    return stats.heap_fragmentation;
+}
+
+// allocate everything, then free it in the opposite order
+static void workload_lifo(void** ptrs, size_t count, struct allocbench_result* result)
+{
+    uint64_t start = rdtsc();
+    for (size_t i = 0; i < count; i++)
+        ptrs[i] = kalloc(16 + i % 256);
+    result->cycles += rdtsc() - start;
+
+    result->fragmentation = heap_fragmentation();
+
+    start = rdtsc();
+    for (size_t i = count; i > 0; i--)
+        kfree(ptrs[i - 1]);
+    result->cycles += rdtsc() - start;
+
+    result->ops = count * 2;
+}
+
+// allocate everything, then free it in the same order
+static void workload_fifo(void** ptrs, size_t count, struct allocbench_result* result)
+{
+    uint64_t start = rdtsc();
+    for (size_t i = 0; i < count; i++)
+        ptrs[i] = kalloc(16 + i % 256);
+    result->cycles += rdtsc() - start;
+
+    result->fragmentation = heap_fragmentation();
+
+    start = rdtsc();
+    for (size_t i = 0; i < count; i++)
+        kfree(ptrs[i]);
+    result->cycles += rdtsc() - start;
+
+    result->ops = count * 2;
+}
+
+// randomly allocate and free blocks of random sizes, mostly small but with the
+// occasional large one
+static void workload_churn(void** ptrs, size_t count, struct allocbench_result* result)
+{
+    memset(ptrs, 0, count * sizeof(void*));
+    size_t rounds = count * 8;
+
+    uint64_t start = rdtsc();
+    for (size_t i = 0; i < rounds; i++) {
+        size_t slot = bench_rand() % count;
+        if (ptrs[slot]) {
+            kfree(ptrs[slot]);
+            ptrs[slot] = NULL;
+        } else {
+            size_t size = bench_rand() % 16 == 0 ? bench_rand() % 16384 : bench_rand() % 512;
+            ptrs[slot] = kalloc(size + 1);
+        }
+    }
+    result->cycles += rdtsc() - start;
+
+    result->fragmentation = heap_fragmentation();
+
+    start = rdtsc();
+    for (size_t i = 0; i < count; i++) {
+        if (ptrs[i])
+            kfree(ptrs[i]);
+    }
+    result->cycles += rdtsc() - start;
+
+    result->ops = rounds + count;
+}
+
+// grow buffers a bit at a time, as something reading data of an unknown size
+// would, with some small allocations in between getting in the way
+static void workload_realloc(void** ptrs, size_t count, struct allocbench_result* result)
+{
+    size_t buffers = MAX(count / 64, 1u);
+    size_t steps = 64;
+
+    uint64_t start = rdtsc();
+    for (size_t i = 0; i < buffers; i++) {
+        void* buf = NULL;
+        for (size_t step = 1; step <= steps; step++) {
+            buf = krealloc(buf, step * 128);
+            if (step % 8 == 0)
+                ptrs[i * 8 + step / 8 - 1] = kalloc(32);
+        }
+        ptrs[buffers * 8 + i] = buf;
+    }
+    result->cycles += rdtsc() - start;
+
+    result->fragmentation = heap_fragmentation();
+
+    start = rdtsc();
+    for (size_t i = 0; i < buffers * 9; i++)
+        kfree(ptrs[i]);
+    result->cycles += rdtsc() - start;
+
+    result->ops = buffers * (steps + steps / 8) + buffers * 9;
+}
+
+// lots of small objects, allocated and freed in batches
+static void workload_small(void** ptrs, size_t count, struct allocbench_result* result)
+{
+    for (int batch = 0; batch < 8; batch++) {
+        uint64_t start = rdtsc();
+        for (size_t i = 0; i < count; i++)
+            ptrs[i] = kalloc(8 + bench_rand() % 57);
+        result->cycles += rdtsc() - start;
+
+        if (batch == 0)
+            result->fragmentation = heap_fragmentation();
+
+        start = rdtsc();
+        for (size_t i = 0; i < count; i++)
+            kfree(ptrs[i]);
+        result->cycles += rdtsc() - start;
+    }
+
+    result->ops = count * 16;
+}
+
+struct workload {
+    const char* name;
+    void (*run)(void** ptrs, size_t count, struct allocbench_result* result);
+};
+
+static struct workload workloads[] = {
+    {"lifo", workload_lifo},
+    {"fifo", workload_fifo},
+    {"churn", workload_churn},
+    {"realloc", workload_realloc},
+    {"small", workload_small},
+};
+
+void allocbench(int argc, char** argv)
+{
+    if (!bench_available()) {
+        printf("No timestamp counter, can't benchmark\n");
+        return;
+    }
+
+    size_t count = ALLOCBENCH_DEFAULT_COUNT;
+    const char* only = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (isdigit(argv[i][0]))
+            count = MAX(atoi(argv[i]), 64);
+        else
+            only = argv[i];
+    }
+
+    void** ptrs = kalloc(count * sizeof(void*));
+    uint32_t khz = bench_tsc_khz();
+    printf("%d live allocations, TSC at %d kHz\n", count, khz);
+    printf("%-8s %8s %10s %9s %6s\n", "workload", "ops", "ops/sec", "cycles/op", "frag");
+
+    for (int i = 0; i < sizeof(workloads) / sizeof(struct workload); i++) {
+        if (only && strcmp(only, workloads[i].name) != 0)
+            continue;
+
+        struct allocbench_result result = {0};
+        bench_srand(ALLOCBENCH_SEED);
+        workloads[i].run(ptrs, count, &result);
+
+        printf("%-8s %8d %10d %9d %5d%%\n",
+            workloads[i].name,
+            result.ops,
+            bench_per_sec(result.ops, result.cycles),
+            bench_div64(result.cycles, result.ops),
+            result.fragmentation
+        );
+        debugf("allocbench %s ops=%d cycles/op=%d frag=%d",
+            workloads[i].name, result.ops, bench_div64(result.cycles, result.ops), result.fragmentation);
+    }
+
+    struct alloc_stats stats;
+    alloc_get_stats(&stats);
+    printf("end state: heap %d%% fragmented, pages %d%% fragmented\n",
+        stats.heap_fragmentation, stats.page_fragmentation);
+
+    kfree(ptrs);
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void allocbench(int argc, char** argv);
@@ -0,0 +1,189 @@
+/**
+ * @file arena.c
+ * @brief Region (arena) allocator for short-lived memory
+ *
+ * An arena hands out memory by bumping a pointer through a chunk of backing
+ * memory, and frees everything it has handed out at once when it is reset or
+ * destroyed. This makes it well suited for scratch memory that only lives as
+ * long as a single command or lookup, as none of it has to go through the
+ * heap individually.
+ *
+ * The backing memory can be anything, including a buffer on the stack. If it
+ * runs out, further chunks are taken from the heap and given back on reset.
+ */
+
+#include "arena.h"
+#include "alloc.h"
+#include "stdlib.h"
+#include <export.h>
+
+static size_t arena_aligned(size_t size)
+{
+    return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Initialise an arena which allocates from the given backing memory.
+ *
+ * @param arena the arena to initialise
+ * @param buffer the backing memory, which must outlive the arena. may be NULL
+ * if size is zero, in which case all memory comes from the heap
+ * @param size the size of the backing memory, in bytes
+ */
+void arena_init(arena_t* arena, void* buffer, size_t size)
+{
+    ASSERT(arena, "NULL arena");
+
+    // make sure the first allocation is aligned
+    size_t misalignment = (uintptr_t)buffer % ARENA_ALIGNMENT;
+    if (buffer && misalignment) {
+        size_t skip = MIN(ARENA_ALIGNMENT - misalignment, size);
+        buffer += skip;
+        size -= skip;
+    }
+
+    arena->first = buffer;
+    arena->first_size = size;
+    arena->base = buffer;
+    arena->size = size;
+    arena->used = 0;
+    arena->overflow = NULL;
+    arena->owned = 0;
+}
+EXPORT_SYM(arena_init);
+
+/**
+ * @brief Create an arena with its backing memory allocated from the heap. The
+ * arena and its backing memory are a single allocation.
+ *
+ * @param size the size of the backing memory, in bytes
+ * @return arena_t* the new arena, which should be destroyed with
+ * `arena_destroy`
+ */
+arena_t* arena_create(size_t size)
+{
+    size_t header_size = arena_aligned(sizeof(arena_t));
+    arena_t* arena = kalloc(header_size + size);
+    arena_init(arena, (void*)arena + header_size, size);
+    arena->owned = 1;
+    return arena;
+}
+EXPORT_SYM(arena_create);
+
+/**
+ * @brief Allocate memory from an arena. The memory stays valid until the arena
+ * is reset or destroyed, and cannot be freed individually.
+ *
+ * @param arena the arena to allocate from
+ * @param size the size to allocate, in bytes
+ * @return void* a pointer to the allocated memory
+ */
+void* arena_alloc(arena_t* arena, size_t size)
+{
+    ASSERT(arena, "NULL arena");
+    size = arena_aligned(size);
+
+    if (arena->size - arena->used < size) {
+        // out of space in the current chunk, so start a new one big enough
+        // for this allocation. whatever was left in the old chunk is wasted,
+        // but that will be reclaimed on reset anyway
+        size_t chunk_size = MAX(size, arena->first_size);
+        struct arena_chunk* chunk = kalloc(sizeof(*chunk) + chunk_size);
+        chunk->next = arena->overflow;
+        chunk->size = chunk_size;
+        arena->overflow = chunk;
+
+        arena->base = (uint8_t*)(chunk + 1);
+        arena->size = chunk_size;
+        arena->used = 0;
+    }
+
+    void* ptr = arena->base + arena->used;
+    arena->used += size;
+    return ptr;
+}
+EXPORT_SYM(arena_alloc);
+
+/**
+ * @brief Allocate memory from an arena and clear it
+ *
+ * @param arena the arena to allocate from
+ * @param size the size to allocate, in bytes
+ * @return void* a pointer to the allocated memory
+ */
+void* arena_allocz(arena_t* arena, size_t size)
+{
+    void* ptr = arena_alloc(arena, size);
+    memset(ptr, 0, size);
+    return ptr;
+}
+EXPORT_SYM(arena_allocz);
+
+/**
+ * @brief Duplicate a string into an arena
+ *
+ * @param arena the arena to allocate the new string from
+ * @param s the string to duplicate
+ * @return char* the duplicated string
+ */
+char* arena_strdup(arena_t* arena, const char* s)
+{
+    return arena_strndup(arena, s, strlen(s));
+}
+EXPORT_SYM(arena_strdup);
+
+/**
+ * @brief Duplicate the first `n` characters of a string into an arena. The
+ * new string is always null-terminated.
+ *
+ * @param arena the arena to allocate the new string from
+ * @param s the string to duplicate
+ * @param n the number of characters to duplicate
+ * @return char* the duplicated string
+ */
+char* arena_strndup(arena_t* arena, const char* s, size_t n)
+{
+    char* str = arena_alloc(arena, n + 1);
+    memcpy(str, s, n);
+    str[n] = '\0';
+    return str;
+}
+EXPORT_SYM(arena_strndup);
+
+/**
+ * @brief Free everything allocated from an arena, so that it can be reused.
+ *
+ * @param arena the arena to reset
+ */
+void arena_reset(arena_t* arena)
+{
+    ASSERT(arena, "NULL arena");
+
+    struct arena_chunk* chunk = arena->overflow;
+    while (chunk) {
+        struct arena_chunk* next = chunk->next;
+        kfree(chunk);
+        chunk = next;
+    }
+
+    arena->overflow = NULL;
+    arena->base = arena->first;
+    arena->size = arena->first_size;
+    arena->used = 0;
+}
+EXPORT_SYM(arena_reset);
+
+/**
+ * @brief Destroy an arena, freeing everything allocated from it. If the arena
+ * was made with `arena_create` the arena itself is also freed, otherwise the
+ * backing memory is left to the caller.
+ *
+ * @param arena the arena to destroy
+ */
+void arena_destroy(arena_t* arena)
+{
+    arena_reset(arena);
+    if (arena->owned)
+        kfree(arena);
+}
+EXPORT_SYM(arena_destroy);
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Alignment of every allocation made from an arena
+#define ARENA_ALIGNMENT     8
+
+// An overflow chunk, allocated from the heap once an arena's own backing
+// memory has been used up. The chunk's memory directly follows this header.
+struct arena_chunk {
+    struct arena_chunk* next;
+    size_t size;
+};
+
+typedef struct arena {
+    // the memory currently being allocated from, and how much of it is used
+    uint8_t* base;
+    size_t size;
+    size_t used;
+    // the backing memory the arena was created with
+    uint8_t* first;
+    size_t first_size;
+    // overflow chunks, most recent first
+    struct arena_chunk* overflow;
+    // non-zero if the arena itself was allocated by `arena_create`
+    int owned;
+} arena_t;
+
+// Declare an arena named `name` backed by `size` bytes on the stack. It must
+// still be destroyed, in case it overflowed onto the heap.
+#define ARENA_ON_STACK(name, size) \
+    uint8_t name ## _backing[size]; \
+    arena_t name; \
+    arena_init(&name, name ## _backing, sizeof(name ## _backing))
+
+void arena_init(arena_t* arena, void* buffer, size_t size);
+arena_t* arena_create(size_t size);
+void* arena_alloc(arena_t* arena, size_t size);
+void* arena_allocz(arena_t* arena, size_t size);
+char* arena_strdup(arena_t* arena, const char* s);
+char* arena_strndup(arena_t* arena, const char* s, size_t n);
+void arena_reset(arena_t* arena);
+void arena_destroy(arena_t* arena);
@@ -0,0 +1,115 @@
+/**
+ * @file bench.c
+ * @brief Helpers for benchmarking with the timestamp counter
+ *
+ * The timestamp counter gives the number of cycles something took, which is
+ * converted to real time by calibrating it against the system timer.
+ */
+
+#include "bench.h"
+#include "kernel.h"
+#include "stdlib.h"
+#include "sys/cpuid.h"
+
+// number of timer ticks (of 10ms) to calibrate the timestamp counter over
+#define BENCH_CALIBRATE_TICKS   10
+
+static uint32_t tsc_khz = 0;
+static uint32_t rand_state = 1;
+
+/**
+ * @brief Check whether benchmarks can be run, i.e. whether the CPU has a
+ * timestamp counter.
+ *
+ * @return int non-zero if benchmarks can be run
+ */
+int bench_available()
+{
+    return cpuid_check_feature("tsc");
+}
+
+/**
+ * @brief Get the frequency of the timestamp counter. This is measured against
+ * the system timer the first time it is called, which takes a short while.
+ *
+ * @return uint32_t the frequency, in kHz
+ */
+uint32_t bench_tsc_khz()
+{
+    if (tsc_khz)
+        return tsc_khz;
+
+    // start measuring right on a tick, so we get whole ticks
+    uint32_t start_tick = kticks();
+    while (kticks() == start_tick)
+        hlt();
+
+    start_tick = kticks();
+    uint64_t start = rdtsc();
+    while (kticks() - start_tick < BENCH_CALIBRATE_TICKS)
+        hlt();
+    uint64_t cycles = rdtsc() - start;
+
+    tsc_khz = bench_div64(cycles, BENCH_CALIBRATE_TICKS * 10);
+    return tsc_khz;
+}
+
+/**
+ * @brief Divide a 64 bit number by a 32 bit one.
+ *
+ * @param n the dividend
+ * @param d the divisor
+ * @return uint32_t the quotient, or 0xffffffff if it would not fit
+ */
+uint32_t bench_div64(uint64_t n, uint32_t d)
+{
+    uint32_t lo = n;
+    uint32_t hi = n >> 32;
+    if (hi >= d)
+        return 0xffffffff;
+
+    uint32_t quotient, remainder;
+    asm("divl %4" : "=a" (quotient), "=d" (remainder) : "a" (lo), "d" (hi), "rm" (d));
+    return quotient;
+}
+
+/**
+ * @brief Work out how many times per second something happened, given how
+ * many cycles it took to happen `count` times.
+ *
+ * @param count the number of times it happened
+ * @param cycles the number of cycles it took
+ * @return uint32_t the rate per second
+ */
+uint32_t bench_per_sec(uint32_t count, uint64_t cycles)
+{
+    if (!cycles)
+        return 0;
+
+    // count * khz * 1000 / cycles, scaled to stay in range
+    uint64_t scaled = (uint64_t)count * bench_tsc_khz();
+    return bench_div64(scaled, MAX(bench_div64(cycles, 1000), 1u));
+}
+
+/**
+ * @brief Seed the benchmark random number generator, so that runs can be
+ * reproduced.
+ *
+ * @param seed the seed
+ */
+void bench_srand(uint32_t seed)
+{
+    rand_state = seed;
+}
+
+/**
+ * @brief Get a pseudo-random number. Not at all suitable for anything other
+ * than generating workloads.
+ *
+ * @return uint32_t a random number between 0 and 2^24 - 1
+ */
+uint32_t bench_rand()
+{
+    rand_state = rand_state * 1103515245 + 12345;
+    return rand_state >> 8;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+
+// Read the CPU's timestamp counter
+static inline uint64_t rdtsc()
+{
+    uint32_t lo, hi;
+    asm volatile("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+int bench_available();
+uint32_t bench_tsc_khz();
+uint32_t bench_div64(uint64_t n, uint32_t d);
+uint32_t bench_per_sec(uint32_t count, uint64_t cycles);
+void bench_srand(uint32_t seed);
+uint32_t bench_rand();
@@ -0,0 +1,241 @@
+/**
+ * @file cksum.c
+ * @brief Checksums: CRC32, Adler32 and the Internet checksum
+ *
+ * CRC32 is the reflected IEEE 802.3 polynomial used by Ethernet, zlib and
+ * others, computed eight bytes at a time with the slicing-by-8 method. Adler32
+ * is the one used by zlib, and the Internet checksum is the one's complement
+ * sum of RFC 1071, as used by IPv4, UDP and TCP.
+ *
+ * Each checksum can be computed over data in pieces, by passing the result of
+ * one call in to the next, starting with the appropriate initial value.
+ */
+
+#include "cksum.h"
+#include <export.h>
+#include "stdlib.h"
+
+#define CRC32_POLY      0xedb88320u
+
+#define ADLER32_MOD     65521
+// the most bytes that can be summed before Adler32's second sum could overflow
+// 32 bits, so the modulo only needs to be taken once per this many bytes
+#define ADLER32_NMAX    5552
+
+// crc32_table[0] is the usual byte-at-a-time table. crc32_table[k][i] is the
+// CRC of byte i followed by k zero bytes, which lets eight bytes be looked up
+// independently and combined
+static uint32_t crc32_table[8][256];
+
+static void crc32_init_tables()
+{
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (crc & 1 ? CRC32_POLY : 0);
+        crc32_table[0][i] = crc;
+    }
+
+    for (uint32_t i = 0; i < 256; i++) {
+        for (int k = 1; k < 8; k++) {
+            uint32_t prev = crc32_table[k - 1][i];
+            crc32_table[k][i] = (prev >> 8) ^ crc32_table[0][prev & 0xff];
+        }
+    }
+}
+
+// the tables are built the first time they are needed. the entry for 1 is
+// never zero once they have been
+static inline void crc32_ensure_tables()
+{
+    if (!crc32_table[0][1])
+        crc32_init_tables();
+}
+
+/**
+ * @brief Calculate the CRC32 of some data, eight bytes at a time.
+ *
+ * @param crc the CRC so far, or CRC32_INIT to start a new one
+ * @param data the data
+ * @param len the length of the data, in bytes
+ * @return uint32_t the CRC of everything so far
+ */
+uint32_t crc32(uint32_t crc, const void* data, size_t len)
+{
+    crc32_ensure_tables();
+
+    const uint8_t* p = data;
+    crc = ~crc;
+
+    // a byte at a time up to a word boundary, so the main loop loads aligned
+    while (len && ((uintptr_t)p & 3)) {
+        crc = crc32_table[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+        len--;
+    }
+
+    while (len >= 8) {
+        uint32_t lo = *(const uint32_t*)p ^ crc;
+        uint32_t hi = *(const uint32_t*)(p + 4);
+        crc = crc32_table[7][lo & 0xff]
+            ^ crc32_table[6][(lo >> 8) & 0xff]
+            ^ crc32_table[5][(lo >> 16) & 0xff]
+            ^ crc32_table[4][lo >> 24]
+            ^ crc32_table[3][hi & 0xff]
+            ^ crc32_table[2][(hi >> 8) & 0xff]
+            ^ crc32_table[1][(hi >> 16) & 0xff]
+            ^ crc32_table[0][hi >> 24];
+        p += 8;
+        len -= 8;
+    }
+
+    while (len--)
+        crc = crc32_table[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+
+    return ~crc;
+}
+EXPORT_SYM(crc32);
+
+/**
+ * @brief Calculate the CRC32 of some data a byte at a time. Gives the same
+ * result as crc32, which should be used instead; this is kept to compare it
+ * against.
+ *
+ * @param crc the CRC so far, or CRC32_INIT to start a new one
+ * @param data the data
+ * @param len the length of the data, in bytes
+ * @return uint32_t the CRC of everything so far
+ */
+uint32_t crc32_bytewise(uint32_t crc, const void* data, size_t len)
+{
+    crc32_ensure_tables();
+
+    const uint8_t* p = data;
+    crc = ~crc;
+    while (len--)
+        crc = crc32_table[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+EXPORT_SYM(crc32_bytewise);
+
+/**
+ * @brief Calculate the Adler32 checksum of some data.
+ *
+ * @param adler the checksum so far, or ADLER32_INIT to start a new one
+ * @param data the data
+ * @param len the length of the data, in bytes
+ * @return uint32_t the checksum of everything so far
+ */
+uint32_t adler32(uint32_t adler, const void* data, size_t len)
+{
+    const uint8_t* p = data;
+    uint32_t a = adler & 0xffff;
+    uint32_t b = adler >> 16;
+
+    while (len) {
+        size_t n = MIN(len, (size_t)ADLER32_NMAX);
+        len -= n;
+
+        while (n >= 8) {
+            a += p[0]; b += a;
+            a += p[1]; b += a;
+            a += p[2]; b += a;
+            a += p[3]; b += a;
+            a += p[4]; b += a;
+            a += p[5]; b += a;
+            a += p[6]; b += a;
+            a += p[7]; b += a;
+            p += 8;
+            n -= 8;
+        }
+        while (n--) {
+            a += *p++;
+            b += a;
+        }
+
+        a %= ADLER32_MOD;
+        b %= ADLER32_MOD;
+    }
+
+    return (b << 16) | a;
+}
+EXPORT_SYM(adler32);
+
+/**
+ * @brief Add some data to a one's complement sum, as used by the Internet
+ * checksum. The data is summed 32 bits at a time, which gives the same result
+ * once folded down to 16 bits as summing 16 bit words would.
+ *
+ * When summing data in pieces, every piece but the last must be an even
+ * number of bytes long.
+ *
+ * @param sum the sum so far, or 0 to start a new one
+ * @param data the data
+ * @param len the length of the data, in bytes
+ * @return uint32_t the partial sum of everything so far, to pass on to another
+ * call or to cksum_inet_fold
+ */
+uint32_t cksum_ones(uint32_t sum, const void* data, size_t len)
+{
+    const uint8_t* p = data;
+    // carries out of the low 32 bits collect in the high ones, and are added
+    // back in at the end
+    uint64_t acc = sum;
+
+    while (len >= 16) {
+        acc += *(const uint32_t*)p;
+        acc += *(const uint32_t*)(p + 4);
+        acc += *(const uint32_t*)(p + 8);
+        acc += *(const uint32_t*)(p + 12);
+        p += 16;
+        len -= 16;
+    }
+    while (len >= 4) {
+        acc += *(const uint32_t*)p;
+        p += 4;
+        len -= 4;
+    }
+    if (len >= 2) {
+        acc += *(const uint16_t*)p;
+        p += 2;
+        len -= 2;
+    }
+    // an odd byte out is padded with a zero after it
+    if (len)
+        acc += *p;
+
+    while (acc >> 32)
+        acc = (acc & 0xffffffff) + (acc >> 32);
+    return acc;
+}
+EXPORT_SYM(cksum_ones);
+
+/**
+ * @brief Turn a one's complement sum into the final Internet checksum.
+ *
+ * @param sum the sum from cksum_ones
+ * @return uint16_t the checksum, as a number to be stored in big-endian order
+ * like any other field of a network header
+ */
+uint16_t cksum_inet_fold(uint32_t sum)
+{
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+
+    // the data was summed in little-endian order, so the result is swapped
+    uint16_t cksum = ~sum;
+    return (cksum >> 8) | (cksum << 8);
+}
+EXPORT_SYM(cksum_inet_fold);
+
+/**
+ * @brief Calculate the Internet checksum of some data.
+ *
+ * @param data the data
+ * @param len the length of the data, in bytes
+ * @return uint16_t the checksum, as a number to be stored in big-endian order
+ */
+uint16_t cksum_inet(const void* data, size_t len)
+{
+    return cksum_inet_fold(cksum_ones(0, data, len));
+}
+EXPORT_SYM(cksum_inet);
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Initial values to pass when starting a new checksum
+#define CRC32_INIT      0
+#define ADLER32_INIT    1
+
+uint32_t crc32(uint32_t crc, const void* data, size_t len);
+uint32_t crc32_bytewise(uint32_t crc, const void* data, size_t len);
+uint32_t adler32(uint32_t adler, const void* data, size_t len);
+uint32_t cksum_ones(uint32_t sum, const void* data, size_t len);
+uint16_t cksum_inet_fold(uint32_t sum);
+uint16_t cksum_inet(const void* data, size_t len);
@@ -0,0 +1,112 @@
+/**
+ * @file cksumbench.c
+ * @brief Checksum benchmark
+ *
+ * Times each of the checksums over a range of buffer sizes, reporting how many
+ * bytes each gets through per cycle. The byte-at-a-time CRC32 is included to
+ * show what slicing-by-8 gains over it. As with the memory benchmark, every
+ * measurement is also written to the debug serial port as a comma separated
+ * table.
+ */
+
+#include "cksumbench.h"
+
+#include <stdint.h>
+#include "stdlib.h"
+#include "alloc.h"
+#include "bench.h"
+#include "cksum.h"
+#include "version.h"
+
+#define CKSUMBENCH_MIN_SIZE     64
+#define CKSUMBENCH_MAX_SIZE     (256 * KiB)
+// each measurement processes at least this much data in total
+#define CKSUMBENCH_MIN_TOTAL    (1 * MiB)
+
+static uint32_t run_crc32(const void* data, size_t size)
+{
+    return crc32(CRC32_INIT, data, size);
+}
+
+static uint32_t run_crc32_bytewise(const void* data, size_t size)
+{
+    return crc32_bytewise(CRC32_INIT, data, size);
+}
+
+static uint32_t run_adler32(const void* data, size_t size)
+{
+    return adler32(ADLER32_INIT, data, size);
+}
+
+static uint32_t run_inet(const void* data, size_t size)
+{
+    return cksum_inet(data, size);
+}
+
+struct cksumbench_algo {
+    const char* name;
+    uint32_t (*run)(const void* data, size_t size);
+};
+
+static struct cksumbench_algo algos[] = {
+    {"crc32", run_crc32},
+    {"crc32-1", run_crc32_bytewise},
+    {"adler32", run_adler32},
+    {"inet", run_inet},
+};
+
+/**
+ * @brief Benchmark the checksums
+ *
+ * Usage: cksum [algorithm]
+ */
+void cksumbench(int argc, char** argv)
+{
+    if (!bench_available()) {
+        printf("No timestamp counter, can't benchmark\n");
+        return;
+    }
+
+    const char* only = argc >= 2 ? argv[1] : NULL;
+
+    uint8_t* buf = kalloc(CKSUMBENCH_MAX_SIZE);
+    for (size_t i = 0; i < CKSUMBENCH_MAX_SIZE; i++)
+        buf[i] = i * 7;
+
+    uint32_t khz = bench_tsc_khz();
+    printf("TSC at %d kHz\n", khz);
+    printf("%-8s %8s %8s %7s\n", "algo", "size", "MiB/s", "B/cyc");
+
+    dprintf_raw("# cksumbench " VER_GIT_REV " " VER_GIT_BRANCH ", tsc %d kHz\n", khz);
+    dprintf_raw("cksumbench,algo,size,mib_per_sec,bytes_per_cycle\n");
+
+    for (int i = 0; i < sizeof(algos) / sizeof(struct cksumbench_algo); i++) {
+        if (only && strcmp(only, algos[i].name) != 0)
+            continue;
+
+        for (size_t size = CKSUMBENCH_MIN_SIZE; size <= CKSUMBENCH_MAX_SIZE; size *= 4) {
+            uint32_t reps = MAX(CKSUMBENCH_MIN_TOTAL / size, 1u);
+            uint32_t total = reps * size;
+
+            // once first, so the data and tables are in the cache
+            algos[i].run(buf, size);
+
+            uint64_t start = rdtsc();
+            for (uint32_t rep = 0; rep < reps; rep++)
+                algos[i].run(buf, size);
+            uint64_t cycles = rdtsc() - start;
+
+            uint32_t mib_per_sec = bench_per_sec(total / KiB, cycles) / KiB;
+            // bytes per cycle, multiplied by 100. the totals are small enough
+            // that the cycle count only saturates on hopelessly slow machines
+            uint32_t bytes_per_cycle = bench_div64((uint64_t)total * 100, MAX(bench_div64(cycles, 1), 1u));
+
+            dprintf_raw("cksumbench,%s,%d,%d,%d.%02d\n", algos[i].name, size,
+                mib_per_sec, bytes_per_cycle / 100, bytes_per_cycle % 100);
+            printf("%-8s %8d %8d %4d.%02d\n", algos[i].name, size,
+                mib_per_sec, bytes_per_cycle / 100, bytes_per_cycle % 100);
+        }
+    }
+
+    kfree(buf);
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void cksumbench(int argc, char** argv);
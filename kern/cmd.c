@@ -0,0 +1,144 @@
+/**
+ * @file cmd.c
+ * @brief Registry of the shell's built-in commands
+ *
+ * Commands are kept in a hash table keyed by name, so looking one up takes the
+ * same time however many there are. The table borrows each command's own name
+ * as its key, so the name is only stored once. Modules can add their own commands, which
+ * are then run in exactly the same way as those built in to the kernel.
+ */
+
+#include "cmd.h"
+#include <export.h>
+#include "htbl.h"
+#include "alloc.h"
+#include "stdlib.h"
+
+// number of argument slots allocated to begin with when splitting a line,
+// doubled each time it runs out
+#define CMD_INITIAL_ARGS    8
+
+static htbl_t* commands;
+
+static void cmd_add(struct command* command)
+{
+    if (!commands)
+        commands = htbl_create_flags(HTBL_BORROW_KEYS);
+
+    // the old entry is removed rather than just having its value replaced, as
+    // its key is the old command's name
+    if (htbl_remove(commands, command->name))
+        debugf("command '%s' replaced", command->name);
+
+    htbl_put(commands, command->name, command);
+}
+
+/**
+ * @brief Register a command with the shell. If a command already exists with
+ * the same name, the new one replaces it.
+ *
+ * @param name the name the command is run by, copied
+ * @param fn the function to call when the command is run
+ */
+void cmd_register(const char* name, cmd_fn_t fn)
+{
+    ASSERT(name && fn, "NULL command name or function");
+
+    struct command* command = kalloc(sizeof(struct command));
+    command->name = strdup(name);
+    command->fn = fn;
+    cmd_add(command);
+}
+EXPORT_SYM(cmd_register);
+
+/**
+ * @brief Register a whole table of commands with the shell at once. The table
+ * isn't copied, so it must persist, but this saves an allocation per command.
+ *
+ * @param commands the commands to register
+ * @param count the number of commands in the table
+ */
+void cmd_register_table(struct command* commands, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        cmd_add(&commands[i]);
+}
+EXPORT_SYM(cmd_register_table);
+
+/**
+ * @brief Find a command by name.
+ *
+ * @param name the name of the command
+ * @return cmd_fn_t the function to run for the command, or NULL if there is no
+ * such command
+ */
+cmd_fn_t cmd_get(const char* name)
+{
+    if (!commands)
+        return NULL;
+
+    struct command* command = htbl_get(commands, name);
+    return command ? command->fn : NULL;
+}
+EXPORT_SYM(cmd_get);
+
+/**
+ * @brief Run the command named by the first argument, if there is one.
+ *
+ * @param argc the number of arguments, including the command's name
+ * @param argv the arguments
+ * @return int non-zero if a command was run, zero if there's no such command
+ */
+int cmd_invoke(int argc, char** argv)
+{
+    cmd_fn_t fn = cmd_get(argv[0]);
+    if (!fn)
+        return 0;
+
+    fn(argc, argv);
+    return 1;
+}
+EXPORT_SYM(cmd_invoke);
+
+/**
+ * @brief Split a command line into words separated by spaces, in a single pass
+ * over the line. The line is modified so that each word is terminated, and the
+ * array of words is allocated from the given arena.
+ *
+ * @param line the line to split
+ * @param arena the arena to allocate the argument array from
+ * @param argv set to the array of words, which is followed by a NULL entry
+ * @return int the number of words found
+ */
+int cmd_split(char* line, arena_t* arena, char*** argv)
+{
+    size_t capacity = CMD_INITIAL_ARGS;
+    char** args = arena_alloc(arena, capacity * sizeof(char*));
+    int argc = 0;
+
+    char* p = line;
+    while (*p) {
+        if (*p == ' ') {
+            *p++ = '\0';
+            continue;
+        }
+
+        // leave room for the NULL terminator. older arrays are simply left in
+        // the arena, which is cheaper than tracking them
+        if (argc + 1 >= capacity) {
+            char** grown = arena_alloc(arena, capacity * 2 * sizeof(char*));
+            memcpy(grown, args, argc * sizeof(char*));
+            args = grown;
+            capacity *= 2;
+        }
+        args[argc++] = p;
+
+        while (*p && *p != ' ')
+            p++;
+    }
+
+    args[argc] = NULL;
+    *argv = args;
+    return argc;
+}
+EXPORT_SYM(cmd_split);
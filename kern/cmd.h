@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stddef.h>
+#include "arena.h"
+
+typedef void (*cmd_fn_t)(int argc, char** argv);
+
+// A shell command, run with the words on its command line as arguments
+struct command {
+    const char* name;
+    cmd_fn_t fn;
+};
+
+void cmd_register(const char* name, cmd_fn_t fn);
+void cmd_register_table(struct command* commands, size_t count);
+cmd_fn_t cmd_get(const char* name);
+int cmd_invoke(int argc, char** argv);
+int cmd_split(char* line, arena_t* arena, char*** argv);
@@ -2,7 +2,18 @@
 #include "htbl.h"
 #include "stdlib.h"
 #include "alloc.h"
+#include "arena.h"
+#include "intern.h"
 
+struct config_watcher {
+    config_watch_fn fn;
+    void* priv;
+    struct config_watcher* next;
+};
+
+// a value is never freed or moved once created, and is overwritten in place
+// when set again, so a pointer to one serves as a handle to its key. a handle
+// looked up before its key is set refers to a value with a zero type
 struct config_value {
     uint8_t type;
     union {
@@ -10,82 +21,117 @@ struct config_value {
         const char* sval;
         void* oval;
     };
+    // called after every change to the value
+    struct config_watcher* watchers;
 };
 
+// namespaces and the keys within them are interned, so a lookup only needs to
+// intern its strings once, and is then matched by pointer
 static htbl_t* namespaces;
 
+// size of the on-stack scratch space used to split up keys, longer keys spill
+// over onto the heap
+#define CONFIG_SCRATCH_SIZE     128
+
 void config_init()
 {
-    namespaces = htbl_create();
+    namespaces = htbl_create_flags(HTBL_INTERN_KEYS);
 }
 
 void config_newns(const char* name)
 {
-    htbl_put(namespaces, name, htbl_create());
+    htbl_put_interned(namespaces, intern(name), htbl_create_flags(HTBL_INTERN_KEYS));
 }
 
 // parse a config key in the format <namespace>:<key>. returns zero on failure,
 // non-zero on success, in which case `namespace` will refer to the namespace
-// and `key` will refer to the key, allocated with `kalloc`
-static int config_parse_key(const char* path, const char** namespace, const char** key)
+// and `key` will refer to the key. the namespace is allocated from `scratch`,
+// the key points into `path`
+static int config_parse_key(arena_t* scratch, const char* path, const char** namespace, const char** key)
 {
     const char* sep = strchr(path, ':');
     if (!sep)
         return 0;
 
-    size_t ns_length = sep - path;
-    char* ns = kalloc(ns_length + 1);
-    memcpy(ns, path, ns_length);
-    ns[ns_length] = '\0';
-    *namespace = ns;
-
-    size_t key_len = strlen(sep + 1);
-    char* k = kalloc(key_len + 1);
-    memcpy(k, sep + 1, key_len);
-    k[key_len] = '\0';
-    *key = k;
+    *namespace = arena_strndup(scratch, path, sep - path);
+    *key = sep + 1;
 
     return 1;
 }
 
-static void* config_get_common(const char* ns, const char* ns_key)
+// get the table for a namespace, or NULL if there is no such namespace. a name
+// which was never interned can't have been made into a namespace
+static htbl_t* config_get_ns(const char* ns)
 {
-    htbl_t* ns_table = htbl_get(namespaces, ns);
-    return htbl_get(ns_table, ns_key);
+    const char* interned = intern_lookup(ns);
+    return interned ? htbl_get_interned(namespaces, interned) : NULL;
 }
 
-void config_set_common(const char* ns, const char* ns_key, void* value)
+static struct config_value* config_get_common(const char* ns, const char* ns_key)
 {
-    htbl_t* ns_table = htbl_get(namespaces, ns);
-    htbl_put(ns_table, ns_key, value);
+    htbl_t* ns_table = config_get_ns(ns);
+    if (!ns_table)
+        return NULL;
+
+    const char* interned = intern_lookup(ns_key);
+    return interned ? htbl_get_interned(ns_table, interned) : NULL;
+}
+
+// get the value for a key, creating an empty one if it doesn't exist yet
+static struct config_value* config_get_slot(const char* ns, const char* ns_key)
+{
+    htbl_t* ns_table = config_get_ns(ns);
+    ASSERT(ns_table, "config namespace does not exist");
+
+    const char* interned = intern(ns_key);
+    struct config_value* value = htbl_get_interned(ns_table, interned);
+    if (!value) {
+        value = kallocz(sizeof(*value));
+        htbl_put_interned(ns_table, interned, value);
+    }
+    return value;
+}
+
+// let everyone watching a value know that it has changed
+static void config_notify(struct config_value* value)
+{
+    for (struct config_watcher* w = value->watchers; w; w = w->next)
+        w->fn(value, w->priv);
 }
 
 void config_setstrns(const char* ns, const char* key, const char* value)
 {
-    struct config_value* old_value = config_get_common(ns, key);
-    if (old_value && old_value->type == CONFIG_TYPE_STR)
-        kfree((void*)old_value->sval);
+    struct config_value* conf_value = config_get_slot(ns, key);
+    const char* old_str = conf_value->type == CONFIG_TYPE_STR ? conf_value->sval : NULL;
 
-    struct config_value* conf_value = kalloc(sizeof(*conf_value));
     conf_value->type = CONFIG_TYPE_STR;
     conf_value->sval = strdup(value);
-    config_set_common(ns, key, conf_value);
+    if (old_str)
+        kfree((void*)old_str);
+
+    config_notify(conf_value);
 }
 
 void config_setobjns(const char* ns, const char* key, void* value)
 {
-    struct config_value* conf_value = kalloc(sizeof(*conf_value));
+    struct config_value* conf_value = config_get_slot(ns, key);
+    if (conf_value->type == CONFIG_TYPE_STR)
+        kfree((void*)conf_value->sval);
+
     conf_value->type = CONFIG_TYPE_OBJ;
     conf_value->oval = value;
-    config_set_common(ns, key, conf_value);
+    config_notify(conf_value);
 }
 
 void config_setintns(const char* ns, const char* key, int value)
 {
-    struct config_value* conf_value = kalloc(sizeof(*conf_value));
+    struct config_value* conf_value = config_get_slot(ns, key);
+    if (conf_value->type == CONFIG_TYPE_STR)
+        kfree((void*)conf_value->sval);
+
     conf_value->type = CONFIG_TYPE_INT;
     conf_value->ival = value;
-    config_set_common(ns, key, conf_value);
+    config_notify(conf_value);
 }
 
 const char* config_getstrns(const char* ns, const char* key)
@@ -114,119 +160,91 @@ int config_getintns(const char* ns, const char* key)
 
 void config_setstr(const char* key, const char* value)
 {
+    ARENA_ON_STACK(scratch, CONFIG_SCRATCH_SIZE);
     const char* ns;
     const char* ns_key;
-    if (!config_parse_key(key, &ns, &ns_key))
-        return;
-    if (!ns || !ns_key)
-        return;
+    if (config_parse_key(&scratch, key, &ns, &ns_key))
+        config_setstrns(ns, ns_key, value);
 
-    config_setstrns(ns, ns_key, value);
-
-    kfree((void*)ns);
-    kfree((void*)ns_key);
+    arena_destroy(&scratch);
 }
 
 void config_setint(const char* key, int value)
 {
+    ARENA_ON_STACK(scratch, CONFIG_SCRATCH_SIZE);
     const char* ns;
     const char* ns_key;
-    if (!config_parse_key(key, &ns, &ns_key))
-        return;
-    if (!ns || !ns_key)
-        return;
-
-    config_setintns(ns, ns_key, value);
+    if (config_parse_key(&scratch, key, &ns, &ns_key))
+        config_setintns(ns, ns_key, value);
 
-    kfree((void*)ns);
-    kfree((void*)ns_key);
+    arena_destroy(&scratch);
 }
 
 void config_setobj(const char* key, void* value)
 {
+    ARENA_ON_STACK(scratch, CONFIG_SCRATCH_SIZE);
     const char* ns;
     const char* ns_key;
-    if (!config_parse_key(key, &ns, &ns_key))
-        return;
-    if (!ns || !ns_key)
-        return;
+    if (config_parse_key(&scratch, key, &ns, &ns_key))
+        config_setobjns(ns, ns_key, value);
 
-    config_setobjns(ns, ns_key, value);
-
-    kfree((void*)ns);
-    kfree((void*)ns_key);
+    arena_destroy(&scratch);
 }
 
 const char* config_getstr(const char* key)
 {
+    ARENA_ON_STACK(scratch, CONFIG_SCRATCH_SIZE);
     const char* ns;
     const char* ns_key;
-    if (!config_parse_key(key, &ns, &ns_key))
-        return NULL;
-    if (!ns || !ns_key)
-        return NULL;
-
-    const char* ret = config_getstrns(ns, ns_key);
-
-    kfree((void*)ns);
-    kfree((void*)ns_key);
+    const char* ret = NULL;
+    if (config_parse_key(&scratch, key, &ns, &ns_key))
+        ret = config_getstrns(ns, ns_key);
 
+    arena_destroy(&scratch);
     return ret;
 }
 
 void* config_getobj(const char* key)
 {
+    ARENA_ON_STACK(scratch, CONFIG_SCRATCH_SIZE);
     const char* ns;
     const char* ns_key;
-    if (!config_parse_key(key, &ns, &ns_key))
-        return NULL;
-    if (!ns || !ns_key)
-        return NULL;
-
-    void* ret = config_getobjns(ns, ns_key);
-
-    kfree((void*)ns);
-    kfree((void*)ns_key);
+    void* ret = NULL;
+    if (config_parse_key(&scratch, key, &ns, &ns_key))
+        ret = config_getobjns(ns, ns_key);
 
+    arena_destroy(&scratch);
     return ret;
 }
 
 int config_getint(const char* key)
 {
+    ARENA_ON_STACK(scratch, CONFIG_SCRATCH_SIZE);
     const char* ns;
     const char* ns_key;
-    if (!config_parse_key(key, &ns, &ns_key))
-        return 0;
-    if (!ns || !ns_key)
-        return 0;
-
-    int ret = config_getintns(ns, ns_key);
-
-    kfree((void*)ns);
-    kfree((void*)ns_key);
+    int ret = 0;
+    if (config_parse_key(&scratch, key, &ns, &ns_key))
+        ret = config_getintns(ns, ns_key);
 
+    arena_destroy(&scratch);
     return ret;
 }
 
 int config_existsns(const char* ns, const char* key)
 {
-    return config_get_common(ns, key) != NULL;
+    return config_gettypens(ns, key) != 0;
 }
 
 int config_exists(const char* key)
 {
+    ARENA_ON_STACK(scratch, CONFIG_SCRATCH_SIZE);
     const char* ns;
     const char* ns_key;
-    if (!config_parse_key(key, &ns, &ns_key))
-        return 0;
-    if (!ns || !ns_key)
-        return 0;
-
-    int ret = config_existsns(ns, ns_key);
-
-    kfree((void*)ns);
-    kfree((void*)ns_key);
+    int ret = 0;
+    if (config_parse_key(&scratch, key, &ns, &ns_key))
+        ret = config_existsns(ns, ns_key);
 
+    arena_destroy(&scratch);
     return ret;
 }
 
@@ -240,18 +258,62 @@ int config_gettypens(const char* ns, const char* key)
 
 int config_gettype(const char* key)
 {
+    ARENA_ON_STACK(scratch, CONFIG_SCRATCH_SIZE);
     const char* ns;
     const char* ns_key;
-    if (!config_parse_key(key, &ns, &ns_key))
-        return 0;
-    if (!ns || !ns_key)
-        return 0;
+    int ret = 0;
+    if (config_parse_key(&scratch, key, &ns, &ns_key))
+        ret = config_gettypens(ns, ns_key);
 
-    int ret = config_gettypens(ns, ns_key);
+    arena_destroy(&scratch);
+    return ret;
+}
 
-    kfree((void*)ns);
-    kfree((void*)ns_key);
 
+config_handle_t config_lookup(const char* path)
+{
+    ARENA_ON_STACK(scratch, CONFIG_SCRATCH_SIZE);
+    const char* ns;
+    const char* ns_key;
+    struct config_value* ret = NULL;
+    if (config_parse_key(&scratch, path, &ns, &ns_key) && config_get_ns(ns))
+        ret = config_get_slot(ns, ns_key);
+
+    arena_destroy(&scratch);
     return ret;
 }
 
+int config_handle_gettype(config_handle_t handle)
+{
+    ASSERT(handle, "NULL config handle");
+    return handle->type;
+}
+
+const char* config_handle_getstr(config_handle_t handle)
+{
+    ASSERT(handle, "NULL config handle");
+    return handle->type == CONFIG_TYPE_STR ? handle->sval : NULL;
+}
+
+int config_handle_getint(config_handle_t handle)
+{
+    ASSERT(handle, "NULL config handle");
+    return handle->type == CONFIG_TYPE_INT ? handle->ival : 0;
+}
+
+void* config_handle_getobj(config_handle_t handle)
+{
+    ASSERT(handle, "NULL config handle");
+    return handle->type == CONFIG_TYPE_OBJ ? handle->oval : NULL;
+}
+
+void config_watch(config_handle_t handle, config_watch_fn fn, void* priv)
+{
+    ASSERT(handle && fn, "NULL config handle or watch function");
+
+    struct config_watcher* watcher = kalloc(sizeof(*watcher));
+    watcher->fn = fn;
+    watcher->priv = priv;
+    watcher->next = handle->watchers;
+    handle->watchers = watcher;
+}
@@ -7,6 +7,10 @@
  *
  * Configuration is append or overwrite only. You cannot delete a key which
  * already exists.
+ *
+ * Keys which are read often should be looked up once with `config_lookup`,
+ * and read through the handle it returns, which avoids splitting up and
+ * hashing the key on every access.
  */
 
 enum config_type {
@@ -16,6 +20,18 @@ enum config_type {
 };
 
 
+/**
+ * A handle to the value of a single key. Handles stay valid for good, and
+ * always refer to the current value of their key.
+ */
+typedef struct config_value* config_handle_t;
+
+/**
+ * Function called when the value behind a handle changes, with the `priv`
+ * given to `config_watch`.
+ */
+typedef void (*config_watch_fn)(config_handle_t handle, void* priv);
+
 /**
  * @brief Initialise the config system
  *
@@ -119,3 +135,40 @@ int config_exists(const char* key);
  */
 int config_gettype(const char* key);
 
+/**
+ * @brief Look up the handle for a key. The key needn't have been set yet, in
+ * which case the handle will refer to its value once it is.
+ *
+ * @param path the key to look up, including its namespace
+ * @return handle to the key's value, NULL if the key is malformed or its
+ * namespace does not exist
+ */
+config_handle_t config_lookup(const char* path);
+
+/**
+ * @brief Get the type of the value behind a handle
+ *
+ * @param handle the handle to the value
+ * @return the config_type of the value, or zero if the key isn't set
+ */
+int config_handle_gettype(config_handle_t handle);
+
+/**
+ * For the following, they are identical in all behaviour to the non-handle
+ * variants above, except that the value is read from the handle rather than
+ * by looking up a key.
+ */
+
+const char* config_handle_getstr(config_handle_t handle);
+int config_handle_getint(config_handle_t handle);
+void* config_handle_getobj(config_handle_t handle);
+
+/**
+ * @brief Have a function called every time the value behind a handle is set,
+ * so that anything worked out from the value can be updated.
+ *
+ * @param handle the handle to watch
+ * @param fn the function to call after the value is set
+ * @param priv passed on to `fn`
+ */
+void config_watch(config_handle_t handle, config_watch_fn fn, void* priv);
@@ -1,8 +1,8 @@
 /**
  * @file env.c
  * @brief An environment which stores a pointer to something keyed by a string.
- * **not** hashed, so uses a linear search, so don't use for performance-sensitive
- * applications.
+ * Backed by a hash table, so has no limit on the number of items, and keys may
+ * be any length.
  */
 
 #include "env.h"
@@ -17,34 +17,20 @@
 env_t* env_init()
 {
     env_t* env = kallocz(sizeof(env_t));
-    env->current = 0;
-    env->max = ENV_SIZE;
-    env->items = kallocz(sizeof(env_item_t) * ENV_SIZE);
+    env->table = htbl_create();
     return env;
 }
 
-static int env_index(env_t* env, const char* key)
-{
-    for (int i = 0; i < env->current; i++) {
-        if (env->items[i].status & ENV_PRESENT 
-                && strcmp(key, env->items[i].key) == 0) {
-            return i;
-        }
-    }
-    return -1;
-}
-
-static int env_first_free(env_t* env)
+/**
+ * @brief Destroy an environment. The values within it are /NOT/ destroyed.
+ *
+ * @param env the environment to destroy
+ */
+void env_destroy(env_t* env)
 {
-    for (int i = 0; i < env->current; i++) {
-        if (env->items[i].status & ENV_EMPTY)
-            return i;
-    }
-
-    if (env->current >= env->max)
-        return -1;
-
-    return env->current++;
+    ASSERT(env, "Tried to destroy NULL environment");
+    htbl_destroy(env->table);
+    kfree(env);
 }
 
 /**
@@ -57,20 +43,7 @@ static int env_first_free(env_t* env)
 void env_put(env_t* env, const char* key, void* value)
 {
     ASSERT(env, "Tried to 'put' before environment was initialised");
-    int index = env_index(env, key);
-    if (index != -1) {
-        env->items[index].value = value;
-    } else {
-        ASSERT(strlen(key) < ENV_KEY_LEN, "Key too long for environment");
-        index = env_first_free(env);
-        if (index != -1) {
-            strcpy(env->items[index].key, key);
-            env->items[index].value = value;
-            env->items[index].status = ENV_PRESENT;
-        } else {
-            log(LOG_WARN, "env tried to put to full environment");
-        }
-    }
+    htbl_put(env->table, key, value);
 }
 
 /**
@@ -78,20 +51,13 @@ void env_put(env_t* env, const char* key, void* value)
  * 
  * @param env the environment
  * @param key the key to remove
- * @return void* the value of the item removed
+ * @return void* the value of the item removed. `NULL` if no item with such a
+ * name exists
  */
 void* env_remove(env_t* env, const char* key)
 {
     ASSERT(env, "Tried to 'remove' before environment was initialised");
-    int index = env_index(env, key);
-
-    if (index != -1) {
-        env_item_t* item = &env->items[index];
-        item->status = ENV_EMPTY;
-        return item;
-    }
-
-    return NULL;
+    return htbl_remove(env->table, key);
 }
 
 /**
@@ -106,11 +72,7 @@ void* env_remove(env_t* env, const char* key)
 void* _env_get(env_t* env, const char* key)
 {
     ASSERT(env, "Tried to 'get' before environment was initialised");
-    int index = env_index(env, key);
-    if (index != -1) 
-        return env->items[index].value;
-    else
-        return NULL;
+    return htbl_get(env->table, key);
 }
 
 /**
@@ -121,11 +83,12 @@ void* _env_get(env_t* env, const char* key)
  */
 void env_iterate(env_t* env, env_iter_func iter)
 {
-    for (int i = 0; i < env->current; i++) {
-        if (env->items[i].status & ENV_PRESENT) {
-            iter(env->items[i].key, env->items[i].value);
-        }
-    }
+    size_t index = 0;
+    const char* key;
+    void* value;
+
+    while (htbl_next(env->table, &index, &key, &value))
+        iter(key, value);
 }
 
 /**
@@ -165,11 +128,26 @@ int env_kvp_str_add(env_t* env, char* kvp_string)
  */
 int env_kvp_lines_add(env_t* env, char* kvp_lines)
 {
-    char* token = strtok(kvp_lines, "\n");
-    while (token) {
-        if (!env_kvp_str_add(env, token))
+    // make room for every line up front, so a large file doesn't grow the
+    // table several times over while it's being added
+    size_t lines = 1;
+    for (const char* p = kvp_lines; (p = strchr(p, '\n')); p++)
+        lines++;
+    htbl_reserve(env->table, htbl_length(env->table) + lines);
+
+    // split the lines in place, skipping empty ones
+    char* line = kvp_lines;
+    while (*line) {
+        char* end = strchr(line, '\n');
+        if (end)
+            *end = '\0';
+
+        if (*line && !env_kvp_str_add(env, line))
             return 0;
-        token = strtok(NULL, "\n");
+
+        if (!end)
+            break;
+        line = end + 1;
     }
     return 1;
 }
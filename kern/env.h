@@ -1,21 +1,9 @@
 #pragma once
 
-#define ENV_SIZE        128
-#define ENV_KEY_LEN     64
-
-#define ENV_PRESENT     (1 << 0)
-#define ENV_EMPTY       (1 << 1)
-
-typedef struct env_item {
-    char status;
-    char key[ENV_KEY_LEN];
-    void* value;
-} env_item_t;
+#include "htbl.h"
 
 typedef struct env {
-    int max;
-    int current;
-    env_item_t* items;
+    htbl_t* table;
 } env_t;
 
 typedef void (*env_iter_func)(const char* k, void* v);
@@ -29,4 +17,5 @@ int env_kvp_lines_add(env_t* env, char* kvp_lines);
 
 #define env_get(e, k, t)      ((t)_env_get(e, k))
 
-env_t* env_init();
\ No newline at end of file
+env_t* env_init();
+void env_destroy(env_t* env);
@@ -1,6 +1,8 @@
 #include "elf.h"
 #include "../stdlib.h"
 #include "../alloc.h"
+#include "../sys/simd.h"
+#include "../cksum.h"
 
 size_t get_elf_size(struct elf_header* hdr)
 {
@@ -19,9 +21,57 @@ size_t get_elf_size(struct elf_header* hdr)
     return total_size;
 }
 
+// Find a section by name, returns NULL if there is no such section
+static struct elf_section_header* elf_find_section(void* elf, const char* name)
+{
+    struct elf_header* hdr = elf;
+    struct elf_section_header* shdr = elf + hdr->shoff;
+    if (!hdr->shoff || hdr->shstrndx >= hdr->shnum)
+        return NULL;
+
+    const char* shstrtab = elf + shdr[hdr->shstrndx].offset;
+    for (int i = 0; i < hdr->shnum; i++) {
+        if (strcmp(shstrtab + shdr[i].name, name) == 0)
+            return &shdr[i];
+    }
+    return NULL;
+}
+
+// Check an image against the CRC32 in its "crc32" section, if it has one,
+// which covers the file contents of every loadable segment in turn. Returns
+// zero if the image is corrupt
+int elf_verify(void* elf)
+{
+    struct elf_section_header* crc_section = elf_find_section(elf, "crc32");
+    if (!crc_section || crc_section->size != sizeof(uint32_t)) {
+        debug("no crc32 section, not verifying image");
+        return 1;
+    }
+
+    struct elf_header* hdr = elf;
+    struct elf_program_header* phdr = elf + hdr->phoff;
+    uint32_t crc = CRC32_INIT;
+    for (int i = 0; i < hdr->phnum; i++, phdr++) {
+        if (phdr->type == ELF_PT_LOAD)
+            crc = crc32(crc, elf + phdr->offset, phdr->filesz);
+    }
+
+    uint32_t expected = *(uint32_t*)(elf + crc_section->offset);
+    if (crc != expected) {
+        logf(LOG_ERROR, "image corrupt: crc32 is %x, expected %x", crc, expected);
+        return 0;
+    }
+    return 1;
+}
+
 void elf_load_mod(void* elf, symtab_handler add_to_symtab)
 {
     struct elf_header* hdr = (struct elf_header*)elf;
+    if (!elf_verify(elf)) {
+        printf("Module image is corrupt, not loading\n");
+        return;
+    }
+
     struct elf_program_header* phdr = elf + hdr->phoff;
     struct elf_section_header* shdr = elf + hdr->shoff;
 
@@ -69,6 +119,10 @@ void elf_run(void* elf, int argc, char** argv)
 {
     struct elf_header* hdr = elf;
     struct elf_program_header* phdr = elf + hdr->phoff;
+    if (!elf_verify(elf)) {
+        printf("Program image is corrupt, not running\n");
+        return;
+    }
 
     // Allocate memory to copy the segments into
     void* base = kalloc(get_elf_size(hdr));
@@ -85,7 +139,9 @@ void elf_run(void* elf, int argc, char** argv)
     }
 
     void (*entry)(int, char**) = (void (*)(int, char**))(base + hdr->entry);
+    simd_user_enter();
     entry(argc, argv);
+    simd_user_exit();
 
     kfree(base);
 }
\ No newline at end of file
@@ -67,5 +67,6 @@ struct elf_section_header
 
 typedef void (*symtab_handler)(void* base, void* symtab, size_t szsymtab);
 
+int elf_verify(void* elf);
 void elf_run(void* elf, int argc, char** argv);
 void elf_load_mod(void* elf, symtab_handler add_to_symtab);
@@ -5,6 +5,8 @@
 #include "../io/driver.h"
 #include "../stdlib.h"
 #include "../alloc.h"
+#include "../slab.h"
+#include "../imap.h"
 
 struct fat_bpb {
     uint8_t reserved0[3]; // boot jmp
@@ -97,6 +99,10 @@ struct fat_priv {
     struct fat_mbr mbr;
 
     blkdev_t* blkdev;
+
+    // cluster number -> the next cluster in its chain, filled in as the FAT
+    // is read so each chain only has to be walked on disk once
+    imap_t* next_cache;
 };
 
 struct fat_file {
@@ -114,6 +120,8 @@ struct fat_file {
     char* dir_contents;
 };
 
+static slab_cache_t file_cache = SLAB_CACHE_INIT("fat_file", sizeof(struct fat_file));
+
 #define FAT_CLUSTER_END     0xfff8
 
 uint32_t sector_of_cluster(struct fat_priv* priv, uint32_t cluster)
@@ -144,6 +152,10 @@ uint32_t next_cluster(fsdev_t* dev, uint32_t current_cluster)
     struct fat_priv* priv = dev->priv;
     blkdev_t* blkdev = priv->blkdev;
 
+    uint32_t cached = imap_tget(priv->next_cache, current_cluster, uintptr_t);
+    if (cached != 0)
+        return cached;
+
     uint8_t fat_table[priv->bytes_per_sector];
     uint32_t fat_offset = current_cluster * 2;
     uint32_t fat_sector = priv->fat_start_sector + (fat_offset / priv->bytes_per_sector);
@@ -152,33 +164,44 @@ uint32_t next_cluster(fsdev_t* dev, uint32_t current_cluster)
     blkdev->read(blkdev, priv->start_lba + fat_sector, 1, fat_table);
 
     uint16_t next_cluster = *(uint16_t*)&fat_table[ent_offset];
+
+    // a zero entry (a free cluster) can't be told apart from a cache miss, but
+    // isn't part of any chain anyway
+    if (next_cluster != 0)
+        imap_put(priv->next_cache, current_cluster, (void*)(uintptr_t)next_cluster);
     return next_cluster;
 }
 
 void* read_cluster_chain(fsdev_t* dev, uint32_t start_cluster, size_t* size)
 {
     struct fat_priv* priv = dev->priv;
-    size_t asize = 0;
+    size_t capacity = 0;
     size_t offset = 0;
-    void* data = kalloc(asize);
+    void* data = NULL;
 
     uint32_t cluster = start_cluster;
     while (cluster > 0 && cluster <= FAT_CLUSTER_END) {
-        asize += priv->bytes_per_cluster;
-        void* ndata = krealloc(data, asize);
-        if (!ndata) {
-            kfree(data);
-            return NULL;
+        // grow geometrically so long chains aren't copied once per cluster
+        if (offset + priv->bytes_per_cluster > capacity) {
+            capacity = MAX(capacity * 2, priv->bytes_per_cluster);
+            void* ndata = krealloc(data, capacity);
+            if (!ndata) {
+                kfree(data);
+                return NULL;
+            }
+            data = ndata;
         }
-        data = ndata;
 
         read_cluster(dev, cluster, data + offset);
         offset += priv->bytes_per_cluster;
         cluster = next_cluster(dev, cluster);
     }
 
+    if (data && offset < capacity)
+        data = krealloc(data, offset);
+
     if (size)
-        *size = asize;
+        *size = offset;
     return data;
 }
 
@@ -366,7 +389,7 @@ file_t* fat_open(fsdev_t* dev, const char** path, size_t pathlen)
     if (!dir)
         return NULL;
 
-    struct fat_file* file = kalloc(sizeof(*file));
+    struct fat_file* file = slab_alloc(&file_cache);
 
     if (!(dir->attrs & (FAT_ATTR_DIR | FAT_ATTR_VOLID))) {
         file->start_cluster = dir->cluster_low;
@@ -380,7 +403,7 @@ file_t* fat_open(fsdev_t* dev, const char** path, size_t pathlen)
         file->current_cluster = FAT_CLUSTER_END;
         char* contents = get_dir_contents(dev, dir, dir->attrs & FAT_ATTR_VOLID);
         if (!contents) {
-            kfree(file);
+            slab_free(&file_cache, file);
             file = NULL;
         } else {
             file->current_offset = 0;
@@ -526,12 +549,12 @@ void fat_close(fsdev_t* dev, file_t* file)
     if (ffile->dir_contents)
         kfree(ffile->dir_contents);
 
-    kfree(file);
+    slab_free(&file_cache, ffile);
 }
 
 static struct device* fat_create(struct device* invoker, blkdev_t* blkdev, uint32_t start_lba, uint32_t num_sectors)
 {
-    struct device* dev = kallocz(sizeof(*dev));
+    struct device* dev = device_alloc();
     struct fat_priv* priv = kalloc(sizeof(*priv));
     fsdev_t* fsdev = kallocz(sizeof(*fsdev));
 
@@ -552,6 +575,7 @@ static struct device* fat_create(struct device* invoker, blkdev_t* blkdev, uint3
     priv->start_lba = start_lba;
     priv->num_sectors = num_sectors;
     priv->blkdev = blkdev;
+    priv->next_cache = imap_create();
 
     ASSERT(sizeof(struct fat_mbr) == 512, "bad FAT MBR size");
     blkdev->read(blkdev, start_lba, 1, &priv->mbr);
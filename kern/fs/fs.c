@@ -4,25 +4,56 @@
 #include "../config.h"
 #include "../stdlib.h"
 #include "../alloc.h"
+#include "../arena.h"
+#include "../slab.h"
+#include "../intern.h"
+
+// size of the on-stack scratch space used to split up paths, longer paths
+// spill over onto the heap
+#define FS_SCRATCH_SIZE     256
 
 struct filehandle {
     file_t* file;
     fsdev_t* fs;
 };
 
+static slab_cache_t handle_cache = SLAB_CACHE_INIT("filehandle", sizeof(filehandle_t));
+
+// the interned name of the device "sys:def_fs" refers to, updated whenever the
+// setting changes. only the name is kept, and the device is looked up on each
+// use, so a device which has since been deregistered is never handed out
+static config_handle_t def_fs_handle;
+static const char* def_fs_name;
+
+static void fs_def_fs_changed(config_handle_t handle, void* priv)
+{
+    const char* name = config_handle_getstr(handle);
+    def_fs_name = name ? intern(name) : NULL;
+}
+
+static fsdev_t* fs_get_default()
+{
+    if (!def_fs_handle) {
+        def_fs_handle = config_lookup("sys:def_fs");
+        config_watch(def_fs_handle, fs_def_fs_changed, NULL);
+        fs_def_fs_changed(def_fs_handle, NULL);
+    }
+
+    return device_get_fs(device_get_by_interned(def_fs_name));
+}
+
 filehandle_t* fs_open(const char* path)
 {
-    const char* def_fs = config_getstrns("sys", "def_fs");
-    struct device* dev = device_get_by_name(def_fs);
-    fsdev_t* fs = device_get_fs(dev);
+    fsdev_t* fs = fs_get_default();
 
-    char* pathbuf = strdup(path);
+    ARENA_ON_STACK(scratch, FS_SCRATCH_SIZE);
+    char* pathbuf = arena_strdup(&scratch, path);
 
     int pathlen = 1;
     char* token = strtok(pathbuf, FS_PATH_SEPARATOR);
     while (strtok(NULL, " ") != NULL) { pathlen++; }
 
-    char** parts = kalloc(sizeof(char*) * pathlen);
+    char** parts = arena_alloc(&scratch, sizeof(char*) * pathlen);
 
     char* tmp = token;
     for (int i = 0; i < pathlen; i++) {
@@ -33,13 +64,12 @@ filehandle_t* fs_open(const char* path)
     file_t* file = fs->open(fs, (const char**)parts, pathlen);
     filehandle_t* handle = NULL;
     if (file) {
-        handle = kalloc(sizeof(*handle));
+        handle = slab_alloc(&handle_cache);
         handle->file = file;
         handle->fs = fs;
     }
 
-    kfree(pathbuf);
-    kfree(parts);
+    arena_destroy(&scratch);
 
     return handle;
 }
@@ -59,19 +89,25 @@ void* fs_read_full(filehandle_t* handle, size_t* count)
 {
     const size_t chunk_size = 2048;
 
-    void* buf = kalloc(chunk_size);
+    size_t capacity = chunk_size;
+    void* buf = kalloc(capacity);
     size_t offset = 0;
-    size_t size = chunk_size;
     while (1) {
-        size_t read = fs_read(handle, buf + offset, 2048);
+        // grow geometrically, so even when the buffer can't be extended in
+        // place the total amount copied stays proportional to the file size
+        if (capacity - offset < chunk_size) {
+            capacity *= 2;
+            buf = krealloc(buf, capacity);
+        }
+
+        int read = fs_read(handle, buf + offset, chunk_size);
         if (read <= 0)
             break;
 
-        size += read;
         offset += read;
-        buf = krealloc(buf, size + chunk_size);
     }
 
+    // give back whatever we over-allocated
     buf = krealloc(buf, offset);
 
     if (count)
@@ -86,6 +122,6 @@ void fs_close(filehandle_t* handle)
 
     if (handle->fs->close)
         handle->fs->close(handle->fs, handle->file);
-    kfree(handle);
+    slab_free(&handle_cache, handle);
 }
 
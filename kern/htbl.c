@@ -4,12 +4,31 @@
  * Uses the FNV-1a hash to get an index into the table, and then performs a
  * linear probe until the matching entry is found. Will dynamically resize, so
  * will not run out of space so long as there is memory available.
+ *
+ * Entries are placed with Robin Hood hashing: an entry being inserted takes the
+ * place of any entry it passes which is closer to its own ideal slot, so no
+ * entry ends up much further from its ideal slot than any other. This keeps
+ * probes short even when the table is fairly full, and lets a lookup for a key
+ * which isn't present stop as soon as it reaches an entry closer to home than
+ * the key would be. Removal shifts the entries following the removed one back
+ * a slot, rather than leaving a marker behind.
+ *
+ * Each entry keeps its key's hash, so that keys are only compared when their
+ * hashes match, and the table can grow without hashing every key again.
+ *
+ * Keys are copied by default, and freed again when they are removed. A table
+ * created with HTBL_BORROW_KEYS uses the caller's keys as they are instead,
+ * and one created with HTBL_INTERN_KEYS interns them, so that a lookup with an
+ * interned key (`htbl_get_interned`) is matched by pointer alone.
  */
 
 #include "htbl.h"
+#include <export.h>
 #include <stddef.h>
 #include "alloc.h"
+#include "slab.h"
 #include "stdlib.h"
+#include "intern.h"
 
 // the number of entries the hash table starts with, note though that this may
 // further be expanded if the hash table gets full enough.
@@ -20,9 +39,15 @@
 // this initial value must be set with care.
 #define HTBL_INITIAL_CAPACITY       32
 
+// the table is expanded once it is this full, as a fraction of its capacity
+#define HTBL_MAX_LOAD_NUM           3
+#define HTBL_MAX_LOAD_DEN           4
+
 struct htbl_entry {
+    // NULL if the entry is empty
     const char* key;
     void* value;
+    uint32_t hash;
 };
 
 struct htbl {
@@ -32,34 +57,50 @@ struct htbl {
     size_t capacity;
     // the total number of items stored in the table currently
     size_t length;
+    // HTBL_* flags given at creation
+    int flags;
 };
 
-htbl_t* htbl_create()
+static slab_cache_t table_cache = SLAB_CACHE_INIT("htbl", sizeof(struct htbl));
+
+htbl_t* htbl_create_flags(int flags)
 {
-    htbl_t* table = kalloc(sizeof(*table));
+    htbl_t* table = slab_alloc(&table_cache);
 
     table->capacity = HTBL_INITIAL_CAPACITY;
     table->length = 0;
+    table->flags = flags;
     table->entries = kallocz(table->capacity * sizeof(struct htbl_entry));
 
     return table;
 }
 
+htbl_t* htbl_create()
+{
+    return htbl_create_flags(0);
+}
+
+// whether the table made its own copies of its keys
+static inline int htbl_owns_keys(const htbl_t* table)
+{
+    return !(table->flags & (HTBL_BORROW_KEYS | HTBL_INTERN_KEYS));
+}
+
 void htbl_destroy(htbl_t* table)
 {
     ASSERT(table && table->entries, "NULL table or entries");
 
-    // free all the keys (which we duplicated, so they're our problem). values
-    // are left to the user
-    for (size_t i = 0; i < table->capacity; i++) {
-        if (table->entries[i].key != NULL) {
-            // cast to void* so we can free in spite of the const qualifier
-            kfree((void*)table->entries[i].key);
+    // free all the keys we copied, so they're our problem. borrowed and
+    // interned keys aren't ours to free, and values are left to the user
+    if (htbl_owns_keys(table)) {
+        for (size_t i = 0; i < table->capacity; i++) {
+            if (table->entries[i].key != NULL)
+                kfree((void*)table->entries[i].key);
         }
     }
 
     kfree(table->entries);
-    kfree(table);
+    slab_free(&table_cache, table);
 }
 
 // FNV-1a hash algorithm, 32 bit; seems to have a reasonable distribution
@@ -67,7 +108,7 @@ void htbl_destroy(htbl_t* table)
 #define FNV_OFFSET_32   2166136261
 #define FNV_PRIME_32    16777619
 
-static uint32_t fnv1a32_hash(const char* key)
+uint32_t htbl_hash(const char* key)
 {
     uint32_t hash = FNV_OFFSET_32;
     const uint8_t* s = (const uint8_t*)key;
@@ -79,63 +120,145 @@ static uint32_t fnv1a32_hash(const char* key)
 
     return hash;
 }
+EXPORT_SYM(htbl_hash);
+
+// the slot an entry with the given hash would ideally be stored in
+static inline size_t htbl_home(const htbl_t* table, uint32_t hash)
+{
+    return (size_t)(hash & (uint32_t)(table->capacity - 1));
+}
+
+// how far the entry at `index` is from its ideal slot
+static inline size_t htbl_distance(const htbl_t* table, size_t index)
+{
+    return (index - htbl_home(table, table->entries[index].hash)) & (table->capacity - 1);
+}
+
+// find the index of the entry for a key, or -1 if it isn't in the table. if
+// both the key and the table's keys are interned, they are compared by pointer
+// alone, as equal strings are interned to the same pointer
+static long htbl_find(const htbl_t* table, const char* key, uint32_t hash, int interned)
+{
+    size_t index = htbl_home(table, hash);
+
+    // go through the table, starting at the key's ideal slot, looking for the
+    // key. if we reach the end, wrap around. once we find an empty slot, or
+    // an entry closer to its ideal slot than the key would be, the key can't
+    // be any further on.
+    for (size_t distance = 0; ; distance++) {
+        struct htbl_entry* entry = &table->entries[index];
+        if (entry->key == NULL || htbl_distance(table, index) < distance)
+            return -1;
+
+        if (interned ? entry->key == key : entry->hash == hash && strcmp(key, entry->key) == 0)
+            return index;
+
+        index = (index + 1) & (table->capacity - 1);
+    }
+}
+
+// place an entry whose key isn't already in the table. the table must have at
+// least one empty slot
+static void htbl_insert(htbl_t* table, struct htbl_entry entry)
+{
+    size_t index = htbl_home(table, entry.hash);
+    size_t distance = 0;
+
+    while (table->entries[index].key != NULL) {
+        // take the place of any entry closer to its ideal slot than this one,
+        // and carry on finding a place for that entry instead
+        size_t existing = htbl_distance(table, index);
+        if (existing < distance) {
+            struct htbl_entry displaced = table->entries[index];
+            table->entries[index] = entry;
+            entry = displaced;
+            distance = existing;
+        }
+
+        index = (index + 1) & (table->capacity - 1);
+        distance++;
+    }
+
+    table->entries[index] = entry;
+}
 
 void* htbl_get(htbl_t* table, const char* key)
 {
     ASSERT(table, "NULL table");
     ASSERT(key, "NULL key");
 
-    uint32_t hash = fnv1a32_hash(key);
-    // bound the index within the table of key at the size of the table
-    size_t index = (size_t)(hash & (uint32_t)(table->capacity - 1));
+    long index = htbl_find(table, key, htbl_hash(key), 0);
+    return index < 0 ? NULL : table->entries[index].value;
+}
 
-    // go through the table, starting at the provided index, looking for the
-    // key. if we reach the end, wrap around.
-    //
-    // this requires that the table be properly formed, i.e. that not all
-    // entires are full
-    while (table->entries[index].key != NULL) {
-        if (strcmp(key, table->entries[index].key) == 0)
-            return table->entries[index].value;
+void* htbl_get_interned(htbl_t* table, const char* key)
+{
+    ASSERT(table, "NULL table");
+    ASSERT(key, "NULL key");
 
-        index++;
-        if (index >= table->capacity) index = 0;
-    }
+    int interned = table->flags & HTBL_INTERN_KEYS;
+    long index = htbl_find(table, key, intern_hash(key), interned);
+    return index < 0 ? NULL : table->entries[index].value;
+}
+
+void* htbl_get_hashed(htbl_t* table, const char* key, uint32_t hash)
+{
+    ASSERT(table, "NULL table");
+    ASSERT(key, "NULL key");
 
-    // we looked at all the values and found nothing, so this mapping must not
-    // exist within the table
-    return NULL;
+    long index = htbl_find(table, key, hash, 0);
+    return index < 0 ? NULL : table->entries[index].value;
 }
 
 // at some point, the table will be full of entries (or realistically, at some
 // threshold before that so we reduce the amount of linear probing we need to
 // do) and we need to expand it.
 //
-// this allocates a new `entries` member and copies all the existing entries to
-// it, before freeing the old entries.
+// this allocates a new `entries` member and moves all the existing entries to
+// it, before freeing the old entries. the stored hashes are reused, so no key
+// is hashed again.
 //
 // returns non-zero on success, zero otherwise.
 static int htbl_expand(htbl_t* table)
 {
-    size_t extended_capacity = table->capacity * 2;
-    struct htbl_entry* extended_entries = kallocz(extended_capacity * sizeof(*extended_entries));
+    struct htbl_entry* old_entries = table->entries;
+    size_t old_capacity = table->capacity;
 
-    // create a temporary table so we can use `htbl_put` to fill the new entry
-    // table
-    htbl_t temp_tbl = {
-        .entries = extended_entries,
-        .capacity = extended_capacity,
-        .length = 0,
-    };
-    for (size_t i = 0; i < table->capacity; i++) {
-        struct htbl_entry entry = table->entries[i];
-        if (entry.key != NULL)
-            htbl_put(&temp_tbl, entry.key, entry.value);
+    table->capacity = old_capacity * 2;
+    table->entries = kallocz(table->capacity * sizeof(struct htbl_entry));
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_entries[i].key != NULL)
+            htbl_insert(table, old_entries[i]);
     }
 
-    kfree(table->entries);
-    table->entries = extended_entries;
-    table->capacity = extended_capacity;
+    kfree(old_entries);
+    return 1;
+}
+
+// insert or replace the mapping for a key, which must already be interned if
+// the table interns its keys
+static int htbl_put_entry(htbl_t* table, const char* key, uint32_t hash, void* value)
+{
+    // if the key is already in the table, just replace its value
+    long index = htbl_find(table, key, hash, table->flags & HTBL_INTERN_KEYS);
+    if (index >= 0) {
+        table->entries[index].value = value;
+        return 1;
+    }
+
+    // if the table is getting crowded enough, expand it first
+    if ((table->length + 1) * HTBL_MAX_LOAD_DEN > table->capacity * HTBL_MAX_LOAD_NUM)
+        htbl_expand(table);
+
+    // unable to find the key within the table, copy (if it's ours) and insert
+    struct htbl_entry entry = {
+        .key = htbl_owns_keys(table) ? strdup(key) : key,
+        .value = value,
+        .hash = hash,
+    };
+    htbl_insert(table, entry);
+    table->length++;
     return 1;
 }
 
@@ -144,32 +267,91 @@ int htbl_put(htbl_t* table, const char* key, void* value)
     ASSERT(table, "NULL table");
     ASSERT(key, "NULL key");
 
-    // if the table is getting crowded enough, expand it first
-    if (table->length >= table->capacity / 2)
-        htbl_expand(table);
+    // an interned key comes with its hash, so is only hashed once, inside
+    // `intern`
+    if (table->flags & HTBL_INTERN_KEYS)
+        return htbl_put_interned(table, intern(key), value);
 
-    // actually set the entry
-    uint32_t hash = fnv1a32_hash(key);
-    // bound the index within the table of key at the size of the table
-    size_t index = (size_t)(hash & (uint32_t)(table->capacity - 1));
+    return htbl_put_entry(table, key, htbl_hash(key), value);
+}
 
-    // see if we can find the key within the table already, do this similar to
-    // htbl_get
-    while (table->entries[index].key != NULL) {
-        if (strcmp(key, table->entries[index].key) == 0) {
-            table->entries[index].value = value;
-            return 1;
-        }
+int htbl_put_interned(htbl_t* table, const char* key, void* value)
+{
+    ASSERT(table, "NULL table");
+    ASSERT(key, "NULL key");
+
+    return htbl_put_entry(table, key, intern_hash(key), value);
+}
+
+int htbl_put_hashed(htbl_t* table, const char* key, uint32_t hash, void* value)
+{
+    ASSERT(table, "NULL table");
+    ASSERT(key, "NULL key");
+    ASSERT(!(table->flags & HTBL_INTERN_KEYS), "Table interns its keys, use htbl_put");
 
-        index++;
-        if (index >= table->capacity) index = 0;
+    return htbl_put_entry(table, key, hash, value);
+}
+
+void* htbl_remove(htbl_t* table, const char* key)
+{
+    ASSERT(table, "NULL table");
+    ASSERT(key, "NULL key");
+
+    long found = htbl_find(table, key, htbl_hash(key), 0);
+    if (found < 0)
+        return NULL;
+
+    size_t index = found;
+    void* value = table->entries[index].value;
+    if (htbl_owns_keys(table))
+        kfree((void*)table->entries[index].key);
+
+    // shift each following entry back a slot, until reaching one which is
+    // already in its ideal slot (or an empty one), so there's no gap for a
+    // lookup to stop at early
+    size_t mask = table->capacity - 1;
+    size_t next = (index + 1) & mask;
+    while (table->entries[next].key != NULL && htbl_distance(table, next) > 0) {
+        table->entries[index] = table->entries[next];
+        index = next;
+        next = (next + 1) & mask;
     }
 
-    // unable to find the key within the table, copy and insert
-    table->entries[index].key = strdup(key);
-    table->entries[index].value = value;
-    table->length++;
-    return 1;
+    table->entries[index].key = NULL;
+    table->entries[index].value = NULL;
+    table->length--;
+    return value;
 }
 
+void htbl_reserve(htbl_t* table, size_t count)
+{
+    ASSERT(table, "NULL table");
 
+    while (count * HTBL_MAX_LOAD_DEN > table->capacity * HTBL_MAX_LOAD_NUM)
+        htbl_expand(table);
+}
+
+size_t htbl_length(htbl_t* table)
+{
+    ASSERT(table, "NULL table");
+    return table->length;
+}
+
+int htbl_next(htbl_t* table, size_t* iter, const char** key, void** value)
+{
+    ASSERT(table && iter, "NULL table or iterator");
+
+    while (*iter < table->capacity) {
+        struct htbl_entry* entry = &table->entries[(*iter)++];
+        if (entry->key == NULL)
+            continue;
+
+        if (key)
+            *key = entry->key;
+        if (value)
+            *value = entry->value;
+        return 1;
+    }
+
+    return 0;
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
 typedef struct htbl htbl_t;
 
 /**
@@ -9,9 +12,31 @@ typedef struct htbl htbl_t;
  */
 htbl_t* htbl_create();
 
+/**
+ * Flags for `htbl_create_flags`.
+ */
+enum htbl_flags {
+    // store the keys given to `htbl_put` as they are, rather than copying
+    // them. the keys must then stay valid and unchanged until they are removed
+    // or the table is destroyed
+    HTBL_BORROW_KEYS    = (1 << 0),
+    // intern the keys given to `htbl_put`, so they can be looked up by pointer
+    // with `htbl_get_interned`. interned keys are never freed, so this is only
+    // for tables whose set of keys is bounded, such as names of things
+    HTBL_INTERN_KEYS    = (1 << 1),
+};
+
+/**
+ * @brief Creates a new hash table, with the given HTBL_* flags
+ *
+ * @param flags HTBL_* flags changing how the table treats its keys
+ * @return pointer to the new table if created, NULL on failure
+ */
+htbl_t* htbl_create_flags(int flags);
+
 /**
  * @brief Destroy a hash table. Will destroy the keys allocated, but will /NOT/
- * destroy the values within the table.
+ * destroy the values within the table, or borrowed or interned keys.
  *
  * @param tbl the table to destroy
  */
@@ -31,15 +56,110 @@ void* htbl_get(htbl_t* table, const char* key);
  * @brief Create a mapping between the given key and value.
  *
  * @param table the table to create the mapping in
- * @param key the key to map the value to; copied so value need not persist
+ * @param key the key to map the value to; copied (or interned) so value need
+ * not persist, unless the table was created with HTBL_BORROW_KEYS
  * @param value the value to map the key to. /NOT/ copied, and must persist
  * @return non-zero value if the mapping was created. zero on failure
  */
 int htbl_put(htbl_t* table, const char* key, void* value);
 
+/**
+ * @brief Get a value from the table, given an interned key. In a table created
+ * with HTBL_INTERN_KEYS this needs neither hashing nor comparing strings, and
+ * in any other table it still saves hashing the key.
+ *
+ * @param table the table to search within
+ * @param key the key to search for, as returned by `intern` or `intern_lookup`
+ * @return pointer to the mapped value for the given key if found, NULL
+ * otherwise
+ */
+void* htbl_get_interned(htbl_t* table, const char* key);
+
+/**
+ * @brief Create a mapping, given an interned key. Equivalent to `htbl_put`,
+ * but saves hashing the key, or interning it again.
+ *
+ * @param table the table to create the mapping in
+ * @param key the key, as returned by `intern` or `intern_lookup`
+ * @param value the value to map the key to
+ * @return non-zero value if the mapping was created. zero on failure
+ */
+int htbl_put_interned(htbl_t* table, const char* key, void* value);
+
+/**
+ * @brief Get a value from the table, given a key and its hash from
+ * `htbl_hash`, for callers which need the hash for something else too.
+ *
+ * @param table the table to search within
+ * @param key the key to search for
+ * @param hash the hash of the key
+ * @return pointer to the mapped value for the given key if found, NULL
+ * otherwise
+ */
+void* htbl_get_hashed(htbl_t* table, const char* key, uint32_t hash);
+
+/**
+ * @brief Create a mapping, given a key and its hash from `htbl_hash`. Not for
+ * tables created with HTBL_INTERN_KEYS, where the hash comes from the pool.
+ *
+ * @param table the table to create the mapping in
+ * @param key the key to map the value to, treated as by `htbl_put`
+ * @param hash the hash of the key
+ * @param value the value to map the key to
+ * @return non-zero value if the mapping was created. zero on failure
+ */
+int htbl_put_hashed(htbl_t* table, const char* key, uint32_t hash, void* value);
+
+/**
+ * @brief Remove the mapping for the given key, if there is one. The copy of the
+ * key made by `htbl_put` is freed, but the value is not.
+ *
+ * @param table the table to remove the mapping from
+ * @param key the key to remove
+ * @return the value the key was mapped to if found, NULL otherwise
+ */
+void* htbl_remove(htbl_t* table, const char* key);
+
+/**
+ * @brief Make room for at least `count` mappings in total, so that adding a
+ * known number of keys grows the table once rather than several times.
+ *
+ * @param table the table to make room in
+ * @param count the number of mappings the table should hold without growing
+ */
+void htbl_reserve(htbl_t* table, size_t count);
+
+/**
+ * @brief Get the number of mappings currently in the table.
+ *
+ * @param table the table to count the mappings of
+ * @return the number of mappings in the table
+ */
+size_t htbl_length(htbl_t* table);
+
+/**
+ * @brief Step through the mappings in a table, in no particular order. The
+ * iterator should start at zero, and is advanced past each mapping returned.
+ * The table must not be modified while it is being iterated over.
+ *
+ * @param table the table to iterate over
+ * @param iter the iterator, set to zero before the first call
+ * @param key set to the next mapping's key, if non-NULL
+ * @param value set to the next mapping's value, if non-NULL
+ * @return non-zero if a mapping was returned, zero once there are none left
+ */
+int htbl_next(htbl_t* table, size_t* iter, const char** key, void** value);
+
 /**
  * Typed table get macro. For convenience mostly, equivalent to `htbl_get` and
  * a cast to the desired type.
  */
 #define htbl_tget(tbl, k, type) (type)htbl_get(tbl, k)
 
+/**
+ * @brief The hash function used for keys, FNV-1a (32 bit).
+ *
+ * @param key the key to hash
+ * @return the hash of the key
+ */
+uint32_t htbl_hash(const char* key);
@@ -0,0 +1,220 @@
+/**
+ * Hash map keyed by integers, for when the natural key of something is a
+ * number (a cluster, a port, a PCI address) or a pointer, so that it doesn't
+ * need formatting into a string to go into a `htbl`.
+ *
+ * Laid out in the same way as `htbl`: open addressing over a power-of-two
+ * sized array, with Robin Hood placement and backward-shift removal. As every
+ * key is a valid integer, slots record how far they are from their ideal slot
+ * (plus one) instead, and zero marks a slot as empty.
+ */
+
+#include "imap.h"
+#include "alloc.h"
+#include "slab.h"
+#include "stdlib.h"
+
+// the number of entries a map starts with. MUST be a power of two, see the
+// note on HTBL_INITIAL_CAPACITY
+#define IMAP_INITIAL_CAPACITY       16
+
+// the map is expanded once it is this full, as a fraction of its capacity
+#define IMAP_MAX_LOAD_NUM           3
+#define IMAP_MAX_LOAD_DEN           4
+
+struct imap_entry {
+    uintptr_t key;
+    void* value;
+    // distance from the ideal slot plus one, zero if the entry is empty
+    uint32_t probe;
+};
+
+struct imap {
+    // array of entries, `capacity` long
+    struct imap_entry* entries;
+    // the number of elements in the `entries` array
+    size_t capacity;
+    // the total number of items stored in the map currently
+    size_t length;
+};
+
+static slab_cache_t map_cache = SLAB_CACHE_INIT("imap", sizeof(struct imap));
+
+imap_t* imap_create()
+{
+    imap_t* map = slab_alloc(&map_cache);
+
+    map->capacity = IMAP_INITIAL_CAPACITY;
+    map->length = 0;
+    map->entries = kallocz(map->capacity * sizeof(struct imap_entry));
+
+    return map;
+}
+
+void imap_destroy(imap_t* map)
+{
+    ASSERT(map && map->entries, "NULL map or entries");
+
+    kfree(map->entries);
+    slab_free(&map_cache, map);
+}
+
+// integer keys are often sequential, or (as pointers) share their low bits, so
+// they're mixed before masking to spread them over the whole table. this is
+// the finaliser from MurmurHash3, with the high half of a 64 bit key folded in
+static uint32_t imap_hash(uintptr_t key)
+{
+    uint32_t hash = (uint32_t)key;
+    if (sizeof(key) > sizeof(hash))
+        hash ^= (uint32_t)((uint64_t)key >> 32);
+
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6b;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+// find the index of the entry for a key, or -1 if it isn't in the map
+static long imap_find(const imap_t* map, uintptr_t key)
+{
+    size_t mask = map->capacity - 1;
+    size_t index = imap_hash(key) & mask;
+
+    // as with `htbl`, a key can't be any further on than an empty slot or an
+    // entry closer to its ideal slot than the key would be
+    for (uint32_t probe = 1; ; probe++) {
+        struct imap_entry* entry = &map->entries[index];
+        if (entry->probe < probe)
+            return -1;
+
+        if (entry->key == key)
+            return index;
+
+        index = (index + 1) & mask;
+    }
+}
+
+// place an entry whose key isn't already in the map. the map must have at
+// least one empty slot
+static void imap_insert(imap_t* map, struct imap_entry entry)
+{
+    size_t mask = map->capacity - 1;
+    size_t index = imap_hash(entry.key) & mask;
+
+    for (entry.probe = 1; map->entries[index].probe != 0; entry.probe++) {
+        // take the place of any entry closer to its ideal slot than this one,
+        // and carry on finding a place for that entry instead
+        if (map->entries[index].probe < entry.probe) {
+            struct imap_entry displaced = map->entries[index];
+            map->entries[index] = entry;
+            entry = displaced;
+        }
+
+        index = (index + 1) & mask;
+    }
+
+    map->entries[index] = entry;
+}
+
+void* imap_get(imap_t* map, uintptr_t key)
+{
+    ASSERT(map, "NULL map");
+
+    long index = imap_find(map, key);
+    return index < 0 ? NULL : map->entries[index].value;
+}
+
+// double the size of the map, moving all the entries over to the new array
+static int imap_expand(imap_t* map)
+{
+    struct imap_entry* old_entries = map->entries;
+    size_t old_capacity = map->capacity;
+
+    map->capacity = old_capacity * 2;
+    map->entries = kallocz(map->capacity * sizeof(struct imap_entry));
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_entries[i].probe != 0)
+            imap_insert(map, old_entries[i]);
+    }
+
+    kfree(old_entries);
+    return 1;
+}
+
+int imap_put(imap_t* map, uintptr_t key, void* value)
+{
+    ASSERT(map, "NULL map");
+
+    long index = imap_find(map, key);
+    if (index >= 0) {
+        map->entries[index].value = value;
+        return 1;
+    }
+
+    if ((map->length + 1) * IMAP_MAX_LOAD_DEN > map->capacity * IMAP_MAX_LOAD_NUM)
+        imap_expand(map);
+
+    struct imap_entry entry = {
+        .key = key,
+        .value = value,
+    };
+    imap_insert(map, entry);
+    map->length++;
+    return 1;
+}
+
+void* imap_remove(imap_t* map, uintptr_t key)
+{
+    ASSERT(map, "NULL map");
+
+    long found = imap_find(map, key);
+    if (found < 0)
+        return NULL;
+
+    size_t index = found;
+    void* value = map->entries[index].value;
+
+    // shift the following entries back a slot, up to the first which is
+    // already in its ideal slot (or empty)
+    size_t mask = map->capacity - 1;
+    size_t next = (index + 1) & mask;
+    while (map->entries[next].probe > 1) {
+        map->entries[index] = map->entries[next];
+        map->entries[index].probe--;
+        index = next;
+        next = (next + 1) & mask;
+    }
+
+    map->entries[index].probe = 0;
+    map->entries[index].value = NULL;
+    map->length--;
+    return value;
+}
+
+size_t imap_length(imap_t* map)
+{
+    ASSERT(map, "NULL map");
+    return map->length;
+}
+
+int imap_next(imap_t* map, size_t* iter, uintptr_t* key, void** value)
+{
+    ASSERT(map && iter, "NULL map or iterator");
+
+    while (*iter < map->capacity) {
+        struct imap_entry* entry = &map->entries[(*iter)++];
+        if (entry->probe == 0)
+            continue;
+
+        if (key)
+            *key = entry->key;
+        if (value)
+            *value = entry->value;
+        return 1;
+    }
+
+    return 0;
+}
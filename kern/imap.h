@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct imap imap_t;
+
+/**
+ * @brief Creates a new map, keyed by integers (or pointers)
+ *
+ * @return pointer to the new map if created, NULL on failure
+ */
+imap_t* imap_create();
+
+/**
+ * @brief Destroy a map. Will /NOT/ destroy the values within the map.
+ *
+ * @param map the map to destroy
+ */
+void imap_destroy(imap_t* map);
+
+/**
+ * @brief Get a value from the map, given a specific key.
+ *
+ * @param map the map to search within
+ * @param key the key to search for
+ * @return the mapped value for the given key if found, NULL otherwise
+ */
+void* imap_get(imap_t* map, uintptr_t key);
+
+/**
+ * @brief Create a mapping between the given key and value, replacing any
+ * existing mapping for the key.
+ *
+ * @param map the map to create the mapping in
+ * @param key the key to map the value to
+ * @param value the value to map the key to. /NOT/ copied, and must persist
+ * @return non-zero value if the mapping was created. zero on failure
+ */
+int imap_put(imap_t* map, uintptr_t key, void* value);
+
+/**
+ * @brief Remove the mapping for the given key, if there is one.
+ *
+ * @param map the map to remove the mapping from
+ * @param key the key to remove
+ * @return the value the key was mapped to if found, NULL otherwise
+ */
+void* imap_remove(imap_t* map, uintptr_t key);
+
+/**
+ * @brief Get the number of mappings currently in the map.
+ *
+ * @param map the map to count the mappings of
+ * @return the number of mappings in the map
+ */
+size_t imap_length(imap_t* map);
+
+/**
+ * @brief Step through the mappings in a map, in no particular order. Works in
+ * the same way as `htbl_next`.
+ *
+ * @param map the map to iterate over
+ * @param iter the iterator, set to zero before the first call
+ * @param key set to the next mapping's key, if non-NULL
+ * @param value set to the next mapping's value, if non-NULL
+ * @return non-zero if a mapping was returned, zero once there are none left
+ */
+int imap_next(imap_t* map, size_t* iter, uintptr_t* key, void** value);
+
+/**
+ * Typed map get macro, equivalent to `imap_get` and a cast to the desired type.
+ */
+#define imap_tget(map, k, type) (type)imap_get(map, k)
+
+/**
+ * Pointer-keyed convenience wrappers, so callers needn't cast their keys.
+ */
+#define imap_pget(map, p)       imap_get(map, (uintptr_t)(p))
+#define imap_pput(map, p, v)    imap_put(map, (uintptr_t)(p), v)
+#define imap_premove(map, p)    imap_remove(map, (uintptr_t)(p))
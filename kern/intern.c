@@ -0,0 +1,82 @@
+/**
+ * @file intern.c
+ * @brief Pool of canonical copies of strings
+ *
+ * Each string is copied into the pool once, along with its hash, and the copy
+ * is handed out to everyone who interns an equal string. Names which are
+ * looked up over and over (device names, symbol names, config keys) can then
+ * be stored once and compared by pointer, in tables created with
+ * HTBL_INTERN_KEYS. Nothing is ever removed from the pool, so it is not for
+ * strings which come and go.
+ */
+
+#include "intern.h"
+#include <export.h>
+#include <stddef.h>
+#include "htbl.h"
+#include "arena.h"
+#include "stdlib.h"
+
+// size of each chunk of memory the strings are copied into
+#define INTERN_CHUNK_SIZE       4096
+
+struct interned {
+    uint32_t hash;
+    char str[];
+};
+
+// maps each string to its `struct interned`. the table borrows its keys (the
+// copies themselves), as it can't intern them without interning into itself
+static htbl_t* pool;
+// the strings never go away, so are packed into an arena rather than each
+// having their own allocation
+static arena_t* strings;
+
+static struct interned* interned_of(const char* str)
+{
+    return (struct interned*)(str - offsetof(struct interned, str));
+}
+
+const char* intern(const char* str)
+{
+    ASSERT(str, "Tried to intern NULL string");
+
+    if (!pool) {
+        pool = htbl_create_flags(HTBL_BORROW_KEYS);
+        strings = arena_create(INTERN_CHUNK_SIZE);
+    }
+
+    // the string is hashed just once, for both the lookup and the insert, and
+    // that hash is kept for the tables the string goes on to be a key in
+    uint32_t hash = htbl_hash(str);
+    struct interned* existing = htbl_get_hashed(pool, str, hash);
+    if (existing)
+        return existing->str;
+
+    size_t len = strlen(str);
+    struct interned* new = arena_alloc(strings, sizeof(*new) + len + 1);
+    new->hash = hash;
+    memcpy(new->str, str, len + 1);
+
+    htbl_put_hashed(pool, new->str, hash, new);
+    return new->str;
+}
+EXPORT_SYM(intern);
+
+const char* intern_lookup(const char* str)
+{
+    ASSERT(str, "Tried to look up NULL string");
+
+    if (!pool)
+        return NULL;
+
+    struct interned* existing = htbl_get(pool, str);
+    return existing ? existing->str : NULL;
+}
+EXPORT_SYM(intern_lookup);
+
+uint32_t intern_hash(const char* interned)
+{
+    return interned_of(interned)->hash;
+}
+EXPORT_SYM(intern_hash);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief Get the canonical copy of a string, adding it to the pool if this is
+ * the first time it has been seen. Equal strings always intern to the same
+ * pointer, so interned strings can be compared with `==`. Interned strings
+ * are never freed.
+ *
+ * @param str the string to intern
+ * @return the canonical copy of the string
+ */
+const char* intern(const char* str);
+
+/**
+ * @brief Get the canonical copy of a string, without adding it to the pool.
+ *
+ * @param str the string to look for
+ * @return the canonical copy of the string if it has been interned, NULL
+ * otherwise
+ */
+const char* intern_lookup(const char* str);
+
+/**
+ * @brief Get the hash of an interned string, as computed by `htbl_hash`
+ * when the string was interned.
+ *
+ * @param interned a string returned by `intern` or `intern_lookup`
+ * @return the hash of the string
+ */
+uint32_t intern_hash(const char* interned);
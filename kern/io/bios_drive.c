@@ -128,12 +128,12 @@ static void bdrive_destroy(struct device* dev)
 
     kfree(blkdev->priv);
     kfree(blkdev);
-    kfree(dev);
+    device_free(dev);
 }
 
 static struct device* bdrive_create(uint8_t drive_nr)
 {
-    struct device* dev = kallocz(sizeof(*dev));
+    struct device* dev = device_alloc();
     dev->type = DEVICE_TYPE_BLOCK;
     dev->destroy = bdrive_destroy;
 
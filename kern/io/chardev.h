@@ -1,14 +1,20 @@
 #pragma once
 
+#include <stddef.h>
+
 typedef struct chardev chardev_t;
 
 typedef int (*char_putc_t)(chardev_t* dev, int c);
 typedef int (*char_getc_t)(chardev_t* dev);
+typedef int (*char_write_t)(chardev_t* dev, const char* buf, size_t len);
 
 #define EOF -1
 
 typedef struct chardev {
     char_putc_t putc;
     char_getc_t getc;
+    // Write a run of characters at once. May be NULL, in which case putc is
+    // used for each character
+    char_write_t write;
     void* priv;
 } chardev_t;
@@ -3,9 +3,19 @@
 #include "chardev.h"
 #include "../config.h"
 
+// handle to "sys:&stdout", looked up on first use
+static config_handle_t stdout_handle;
+
+static chardev_t* cl_output()
+{
+    if (!stdout_handle)
+        stdout_handle = config_lookup("sys:&stdout");
+    return *(chardev_t**)config_handle_getobj(stdout_handle);
+}
+
 void cl_repeat(char c, int n)
 {
-    chardev_t* output = *(chardev_t**)config_getobj("sys:&stdout");
+    chardev_t* output = cl_output();
     while (n > 0) {
         output->putc(output, c);
         n--;
@@ -17,7 +27,7 @@ void cl_box(char corner, char v_edge, char h_edge, int width, const char* conten
     // the number of chars available for text output (we keep one padding on either side,
     // and one box char on each side as well)
     const int nr_textchr = width - 4;
-    chardev_t* output = *(chardev_t**)config_getobj("sys:&stdout");
+    chardev_t* output = cl_output();
 
     output->putc(output, corner);
     cl_repeat(h_edge, nr_textchr + 2);
@@ -2,6 +2,25 @@
 #include "stddef.h"
 #include "../stdlib.h"
 
+// move to the start of the next row, scrolling if we're on the last one
+static void console_newline(console_t* con)
+{
+    con->x_pos = 0;
+    con->y_pos++;
+    if (con->y_pos >= con->height) {
+        con->y_pos--;
+        con->scroll(con);
+        con->invalidate(con, 0, 0, con->width, con->height);
+    }
+}
+
+// invalidate the current row from column `start` up to the cursor
+static void console_invalidate_from(console_t* con, int start)
+{
+    if (con->x_pos > start)
+        con->invalidate(con, start, con->y_pos, con->x_pos - start, 1);
+}
+
 /**
  * @brief Write a single character to the console device
  *
@@ -11,13 +30,7 @@
 void console_putc(console_t* con, char c)
 {
     if (c == '\n') {
-        con->x_pos = 0;
-        con->y_pos++;
-        if (con->y_pos >= con->height) {
-            con->y_pos--;
-            con->scroll(con);
-            con->invalidate(con, 0, 0, con->width, con->height);
-        }
+        console_newline(con);
         con->set_cursor(con, con->x_pos, con->y_pos);
         return;
     } else if (c == '\b') {
@@ -34,16 +47,51 @@ void console_putc(console_t* con, char c)
     con->invalidate(con, con->x_pos, con->y_pos, 1, 1);
     con->x_pos++;
 
-    if (con->x_pos >= con->width) {
-        con->x_pos = 0;
-        con->y_pos++;
-        if (con->y_pos >= con->height) {
-            con->y_pos--;
-            con->scroll(con);
-            con->invalidate(con, 0, 0, con->width, con->height);
+    if (con->x_pos >= con->width)
+        console_newline(con);
+
+    con->set_cursor(con, con->x_pos, con->y_pos);
+}
+
+/**
+ * @brief Write a run of characters to the console device. Unlike calling
+ * console_putc for each character, each row written to is invalidated once
+ * and the cursor is only moved at the end.
+ *
+ * @param con the console to write to
+ * @param buf the characters to write
+ * @param len the number of characters
+ */
+void console_write(console_t* con, const char* buf, size_t len)
+{
+    // the first column on this row written to since it was last invalidated
+    int start = con->x_pos;
+
+    for (size_t i = 0; i < len; i++) {
+        char c = buf[i];
+        if (c == '\n' || c == '\r' || c == '\b') {
+            console_invalidate_from(con, start);
+            if (c == '\n')
+                console_newline(con);
+            else if (c == '\r')
+                con->x_pos = 0;
+            else
+                console_erase(con);
+            start = con->x_pos;
+            continue;
+        }
+
+        con->put_xy(con, con->x_pos, con->y_pos, c);
+        con->x_pos++;
+
+        if (con->x_pos >= con->width) {
+            console_invalidate_from(con, start);
+            console_newline(con);
+            start = 0;
         }
     }
 
+    console_invalidate_from(con, start);
     con->set_cursor(con, con->x_pos, con->y_pos);
 }
 
@@ -72,11 +120,6 @@ void console_pad(console_t* con, int n)
 
 void console_clear(console_t* con)
 {
-    for (int y = 0; y < con->height; y++) {
-        for (int x = 0; x < con->width; x++) {
-            con->put_xy(con, x, y, ' ');
-        }
-    }
     con->clear(con);
     con->invalidate(con, 0, 0, con->width, con->height);
     con->x_pos = 0;
@@ -103,9 +146,17 @@ static int chardev_putc(chardev_t* dev, int c)
     return 1;
 }
 
+static int chardev_write(chardev_t* dev, const char* buf, size_t len)
+{
+    console_t* con = (console_t*)dev->priv;
+    console_write(con, buf, len);
+    return len;
+}
+
 void console_get_chardev(console_t* con, chardev_t* chardev)
 {
     chardev->putc = chardev_putc;
+    chardev->write = chardev_write;
     chardev->getc = NULL;
     chardev->priv = con;
 }
@@ -18,7 +18,8 @@ typedef struct console_state
     // written to display before invalidate is called, or it may be entirely
     // ignored. It is just a hint to the console.
     void (*invalidate)(struct console_state* con, int x, int y, int width, int height);
-    // Called before invalidate on a clear
+    // Clear the whole console to the current background colour. Called before
+    // invalidate on a clear
     void (*clear)(struct console_state* con);
 
     int x_pos, y_pos;
@@ -27,6 +28,7 @@ typedef struct console_state
 } console_t;
 
 void console_putc(console_t* con, char c);
+void console_write(console_t* con, const char* buf, size_t len);
 void console_erase(console_t* con);
 void console_pad(console_t* con, int n);
 void console_clear(console_t* con);
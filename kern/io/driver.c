@@ -3,10 +3,20 @@
 #include "../stdlib.h"
 #include "../alloc.h"
 #include "../list.h"
+#include "../slab.h"
+#include "../htbl.h"
+#include "../intern.h"
 
 struct list drivers;
 struct list devices;
 
+static slab_cache_t device_cache = SLAB_CACHE_INIT("device", sizeof(struct device));
+static slab_cache_t chardev_cache = SLAB_CACHE_INIT("chardev", sizeof(chardev_t));
+
+// index of the registered devices by interned name, the first registered wins
+// if several share a name
+static htbl_t* devices_by_name;
+
 /**
  * @brief Initialise the driver manager.
  *
@@ -15,7 +25,74 @@ void driver_init()
 {
     list_init(&drivers);
     list_init(&devices);
+    devices_by_name = htbl_create_flags(HTBL_INTERN_KEYS);
+}
+
+/**
+ * @brief Allocate a device. The device is cleared, so only the members which
+ * are used need to be filled in.
+ *
+ * @return struct device* the new device, which should be freed with
+ * `device_free` (usually from its destroy function)
+ */
+struct device* device_alloc()
+{
+    return slab_allocz(&device_cache);
+}
+EXPORT_SYM(device_alloc);
+
+/**
+ * @brief Free a device allocated with `device_alloc`.
+ *
+ * @param device the device to free
+ */
+void device_free(struct device* device)
+{
+    slab_free(&device_cache, device);
 }
+EXPORT_SYM(device_free);
+
+/**
+ * @brief Allocate a chardev.
+ *
+ * @return chardev_t* the new chardev, which should be freed with `chardev_free`
+ */
+chardev_t* chardev_alloc()
+{
+    return slab_allocz(&chardev_cache);
+}
+EXPORT_SYM(chardev_alloc);
+
+/**
+ * @brief Free a chardev allocated with `chardev_alloc`.
+ *
+ * @param chardev the chardev to free
+ */
+void chardev_free(chardev_t* chardev)
+{
+    slab_free(&chardev_cache, chardev);
+}
+EXPORT_SYM(chardev_free);
+
+/**
+ * @brief Write a run of characters to a chardev, in one go if the device
+ * supports it.
+ *
+ * @param chardev the chardev to write to
+ * @param buf the characters to write
+ * @param len the number of characters
+ * @return int the number of characters written
+ */
+int chardev_write_buf(chardev_t* chardev, const char* buf, size_t len)
+{
+    if (chardev->write)
+        return chardev->write(chardev, buf, len);
+
+    for (size_t i = 0; i < len; i++)
+        chardev->putc(chardev, buf[i]);
+    return len;
+}
+EXPORT_SYM(chardev_write_buf);
 
 /**
  * @brief Register a device.
@@ -26,6 +103,9 @@ void device_register(struct device* device)
 {
     debugf("registering device %s", device->name);
     list_append(&devices, list_node(device));
+    const char* name = intern(device->name);
+    if (!htbl_get_interned(devices_by_name, name))
+        htbl_put_interned(devices_by_name, name, device);
 
     LIST_FOREACH(current, &drivers) {
         struct driver* drv = list_value(current);
@@ -37,6 +117,25 @@ void device_register(struct device* device)
 }
 EXPORT_SYM(device_register);
 
+// drop a deregistered device from the name index, handing its name over to
+// the next device registered under it, if there is one
+static void device_unindex(struct device* device)
+{
+    // the device's name was interned when it was registered
+    const char* name = intern_lookup(device->name);
+    if (htbl_get_interned(devices_by_name, name) != device)
+        return;
+
+    htbl_remove(devices_by_name, name);
+    LIST_FOREACH(current, &devices) {
+        struct device* dev = list_value(current);
+        if (dev != device && strcmp(name, dev->name) == 0) {
+            htbl_put_interned(devices_by_name, name, dev);
+            return;
+        }
+    }
+}
+
 /**
  * @brief Deregister a single device, and all of its subdevices (if there are any).
  *
@@ -54,6 +153,7 @@ bool device_deregister(struct device* device)
             device_deregister_subdevices(device);
 
             // only now is it safe to destroy this device
+            device_unindex(device);
             if (device->destroy)
                 device->destroy(device);
             list_remove(current);
@@ -258,16 +358,26 @@ EXPORT_SYM(driver_get_by_modname);
  */
 struct device* device_get_by_name(const char* name)
 {
-    LIST_FOREACH(current, &devices) {
-        struct device* dev = list_value(current);
-        if (strcmp(name, dev->name) == 0) {
-            return dev;
-        }
-    }
-    return NULL;
+    // a name which was never interned can't belong to a registered device
+    const char* interned = intern_lookup(name);
+    return interned ? device_get_by_interned(interned) : NULL;
 }
 EXPORT_SYM(device_get_by_name);
 
+/**
+ * @brief Get a device by its name, which has already been interned. Cheaper
+ * than device_get_by_name for callers which look the same name up repeatedly.
+ *
+ * @param name the interned name of the device
+ * @return struct device* the first device matching name if present, NULL if no
+ * such device exists.
+ */
+struct device* device_get_by_interned(const char* name)
+{
+    return htbl_get_interned(devices_by_name, name);
+}
+EXPORT_SYM(device_get_by_interned);
+
 /**
  * @brief For a device name, get the first available suffix for a given prefix.
  *
@@ -95,6 +95,12 @@ struct driver* driver_get_by_modname(const char* modname);
 void driver_foreach(void (*fn)(struct driver*));
 void driver_probe_for(enum device_type type, struct device* invoker);
 
+struct device* device_alloc();
+void device_free(struct device* device);
+chardev_t* chardev_alloc();
+void chardev_free(chardev_t* chardev);
+int chardev_write_buf(chardev_t* chardev, const char* buf, size_t len);
+
 void device_register(struct device* device);
 bool device_deregister(struct device* device);
 bool device_deregister_subdevices(struct device* device);
@@ -103,6 +109,7 @@ int device_get_first_available_suffix(const char* prefix);
 void device_foreach(void (*fn)(struct device*));
 struct device* device_firstmatch(bool (*pred)(const struct device*));
 struct device* device_get_by_name(const char* name);
+struct device* device_get_by_interned(const char* name);
 chardev_t* device_get_chardev(struct device* dev);
 console_t* device_get_console(struct device* dev);
 blkdev_t* device_get_blkdev(struct device* dev);
@@ -140,8 +140,19 @@ static void fb_scroll(console_t* con)
 {
     fbcon_priv_t* priv = con->priv;
     fbdev_t* fb = priv->fb;
-    // TODO: replace with bulk copy?
     fb->shift(fb, priv->font.char_height);
+
+    // the cursor moved up a row along with everything else, so keep tracking
+    // it there; it's gone entirely if it was on the top row. otherwise it'd be
+    // left behind, and the next fb_set_cursor would blank whatever was
+    // scrolled into its old cell instead
+    if (priv->cursor_y > 0) {
+        priv->cursor_y--;
+    } else {
+        priv->cursor_x = -1;
+        priv->cursor_y = -1;
+    }
+
     console_clear_row(con, con->y_pos);
 }
 
@@ -163,12 +174,13 @@ static void fb_clear(console_t* con)
     int width = fbcon_priv->fb->width;
     int height = fbcon_priv->fb->height;
 
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            fb->put_pixel(fb, x, y, fbcon_priv->bg_colour);
-        }
-    }
+    fb->fill(fb, 0, 0, width, height, fbcon_priv->bg_colour);
+    // console_clear only invalidates whole character cells, which can leave a
+    // strip along the right and bottom edges
     fb->invalidate(fb, 0, 0, width, height);
+    // the cursor has been cleared along with everything else
+    fbcon_priv->cursor_x = -1;
+    fbcon_priv->cursor_y = -1;
 }
 
 void fbcon_destroy(struct device* dev)
@@ -176,7 +188,7 @@ void fbcon_destroy(struct device* dev)
     console_t* con = dev->internal_dev;
     kfree(con->priv);
     kfree(con);
-    kfree(dev);
+    device_free(dev);
 }
 
 static void fbcon_gencursor(console_t* con)
@@ -280,7 +292,7 @@ static struct device* fbcon_create(fbdev_t* fb)
     con->clear = fb_clear;
     con->scroll = fb_scroll;
 
-    struct device* dev = kallocz(sizeof(*dev));
+    struct device* dev = device_alloc();
     dev->destroy = fbcon_destroy;
     dev->setparam = fbcon_setparam;
     dev->inform = fbcon_inform;
@@ -317,8 +329,8 @@ static void fbcon_dev_foreach_callback(struct device* dev)
             if (vga)
                 device_deregister(vga);
             console = device_get_console(new_con);
-            kfree(stdout);
-            stdout = kalloc(sizeof(*stdout));
+            chardev_free(stdout);
+            stdout = chardev_alloc();
             console_get_chardev(console, stdout);
         }
     }
@@ -8,6 +8,8 @@ typedef struct framebuffer_device fbdev_t;
 typedef struct framebuffer_device {
     // TODO: bulk writes
     void (*put_pixel)(fbdev_t* dev, int x, int y, fbcolour_t colour);
+    // Fill a rectangle with a single colour
+    void (*fill)(fbdev_t* dev, int x, int y, int width, int height, fbcolour_t colour);
     fbcolour_t (*get_pixel)(fbdev_t* dev, int x, int y);
     void (*invalidate)(fbdev_t* dev, int x, int y, int width, int height);
     void (*shift)(fbdev_t* dev, int height);
@@ -87,6 +87,7 @@ static int chardev_getc(chardev_t* dev)
 void keyboard_get_chardev(chardev_t* dev)
 {
     dev->getc = chardev_getc;
+    dev->write = NULL;
     dev->putc = NULL;
     dev->priv = NULL;
 }
\ No newline at end of file
@@ -47,6 +47,14 @@ static int chardev_putc(chardev_t* dev, int c)
     return 1;
 }
 
+static int chardev_write(chardev_t* dev, const char* buf, size_t len)
+{
+    struct serial_port* port = (struct serial_port*)dev->priv;
+    for (size_t i = 0; i < len; i++)
+        serial_putc(port, buf[i]);
+    return len;
+}
+
 static int chardev_getc(chardev_t* dev)
 {
     struct serial_port* port = (struct serial_port*)dev->priv;
@@ -56,6 +64,7 @@ static int chardev_getc(chardev_t* dev)
 static void serial_get_chardev(struct serial_port* port, chardev_t* chardev)
 {
     chardev->putc = chardev_putc;
+    chardev->write = chardev_write;
     chardev->getc = chardev_getc;
     chardev->priv = port;
 }
@@ -63,7 +72,8 @@ static void serial_get_chardev(struct serial_port* port, chardev_t* chardev)
 static void serial_destroy(struct device* dev)
 {
     kfree(dev->device_priv);
-    kfree(dev);
+    chardev_free(dev->internal_dev);
+    device_free(dev);
 }
 
 static struct device* serial_new_dev(uint16_t iobase, uint32_t baudrate)
@@ -74,13 +84,13 @@ static struct device* serial_new_dev(uint16_t iobase, uint32_t baudrate)
     sp->iobase = iobase;
     sp->baudrate = baudrate;
 
-    struct device* dev = kalloc(sizeof(*dev));
+    struct device* dev = device_alloc();
     dev->type = DEVICE_TYPE_CHAR;
     dev->destroy = serial_destroy;
     sprintf(dev->name, "sp%d", sp_index++);
     dev->device_priv = sp;
 
-    dev->internal_dev = kalloc(sizeof(chardev_t));
+    dev->internal_dev = chardev_alloc();
     serial_get_chardev(sp, dev->internal_dev);
 
     return dev;
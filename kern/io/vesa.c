@@ -288,6 +288,48 @@ uint32_t vesa_get_pixel(fbdev_t* dev, int x, int y)
     return *(uint32_t*)&device->backbuffer[(x * device->bytes_per_pixel) + device->pitch * y];
 }
 
+/**
+ * @brief Fill a rectangle of the screen with a single colour. As with
+ * vesa_put_pixel, no bounds checking is done.
+ *
+ * @param device the device to fill on
+ * @param x the x position of the rectangle
+ * @param y the y position of the rectangle
+ * @param width the width of the rectangle
+ * @param height the height of the rectangle
+ * @param colour the colour to fill with, in the device's format
+ */
+void vesa_fill(fbdev_t* dev, int x, int y, int width, int height, uint32_t colour)
+{
+    struct vesa_priv* device = dev->priv;
+    uint8_t* row = device->backbuffer + (x * device->bytes_per_pixel) + device->pitch * y;
+
+    // when the rows are the full width of the screen with no padding, they can
+    // all be filled at once
+    if (x == 0 && width * device->bytes_per_pixel == device->pitch) {
+        width *= height;
+        height = 1;
+    }
+
+    for (int i = 0; i < height; i++, row += device->pitch) {
+        switch (device->bytes_per_pixel) {
+        case 1:
+            memset(row, colour, width);
+            break;
+        case 2:
+            memset16(row, colour, width);
+            break;
+        case 4:
+            memset32(row, colour, width);
+            break;
+        default:
+            for (int px = 0; px < width; px++)
+                memcpy(row + px * device->bytes_per_pixel, &colour, device->bytes_per_pixel);
+            break;
+        }
+    }
+}
+
 /**
  * @brief Shift the entire screen up
  *
@@ -297,11 +339,14 @@ uint32_t vesa_get_pixel(fbdev_t* dev, int x, int y)
 void vesa_shift(fbdev_t* dev, int yshift)
 {
     struct vesa_priv* device = dev->priv;
-    for (int y = 0; y < device->height - yshift; y++) {
-        int src_offset = device->pitch * y;
-        int dst_offset = device->pitch * (y + yshift);
-        memcpy(device->backbuffer + src_offset, device->backbuffer + dst_offset, device->pitch);
-    }
+    if (yshift <= 0 || yshift >= device->height)
+        return;
+
+    // the rows are contiguous in the back buffer, so they can all be moved up
+    // at once
+    size_t offset = device->pitch * yshift;
+    memmove(device->backbuffer, device->backbuffer + offset,
+        device->pitch * (device->height - yshift));
 }
 
 /**
@@ -389,9 +434,10 @@ static void vesa_probe(struct driver* driver)
     fbdev->get_pixel = vesa_get_pixel;
     fbdev->invalidate = vesa_invalidate;
     fbdev->put_pixel = vesa_put_pixel;
+    fbdev->fill = vesa_fill;
     fbdev->shift = vesa_shift;
 
-    struct device* dev = kalloc(sizeof(*dev));
+    struct device* dev = device_alloc();
     dev->internal_dev = fbdev;
     dev->type = DEVICE_TYPE_FRAMEBUFFER;
     sprintf(dev->name, "vesafb%d", device_get_first_available_suffix("vesafb"));
@@ -74,15 +74,18 @@ static void vga_put_xy(console_t* con, int x, int y, char c)
 static void vga_scroll(console_t* con)
 {
     struct vga_state* state = con->priv;
-    for(int y = 0; y < con->height; y++) {
-        for(int x = 0; x < con->width; x++) {
-            state->vga_buffer[(y * con->width) + x] = state->vga_buffer[(y + 1) * con->width + x];
-        }
-    }
+    memmove(state->vga_buffer, state->vga_buffer + con->width,
+        (con->height - 1) * con->width * sizeof(*state->vga_buffer));
 
     console_clear_row(con, con->y_pos);
 }
 
+static void vga_clear(console_t* con)
+{
+    struct vga_state* state = con->priv;
+    memset16(state->vga_buffer, vga_entry(' ', state->colour), con->width * con->height);
+}
+
 static void vga_set_mode(uint8_t mode)
 {
     struct int_regs regs;
@@ -121,7 +124,7 @@ console_t* vga_init(uint16_t colour)
     con->scroll = vga_scroll;
     con->set_colour = vga_set_colour;
     con->invalidate = vga_null;
-    con->clear = vga_null;
+    con->clear = vga_clear;
 
     con->width = 80;
     con->height = 25;
@@ -142,7 +145,7 @@ static void vga_probe(struct driver* driver)
     if (!driver->first_probe)
         return;
 
-    struct device* dev = kalloc(sizeof(*dev));
+    struct device* dev = device_alloc();
     dev->type = DEVICE_TYPE_CON;
     sprintf(dev->name, "vga%d", 0);
     dev->destroy = NULL; // TODO
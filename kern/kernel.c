@@ -12,6 +12,7 @@
 #include "sys/gdt.h"
 #include "sys/bios.h"
 #include "sys/syscall.h"
+#include "sys/simd.h"
 #include "syscalls.h"
 #include "stdlib.h"
 #include "kernel.h"
@@ -239,6 +240,62 @@ void kernel_late_init()
     hang();
 }
 
+extern int _kload_addr;
+
+/**
+ * @brief Give all the usable memory above 1 MiB to the allocator. The region
+ * the kernel was loaded into becomes the heap, starting just after the kernel,
+ * and every other region is added alongside it.
+ *
+ * @param start_info the startup information from the loader
+ */
+static void init_memory(struct kstart_info* start_info)
+{
+    uint64_t kstart = (uint32_t)&_kload_addr;
+    uint64_t kend = (uint32_t)start_info->memory_start;
+
+    if (!start_info->memory_map_entries) {
+        // no memory map, so all we know is the number of 64 KiB blocks above
+        // 16 MiB (which is where the kernel is)
+        init_alloc(start_info->memory_start, 16 * MiB + start_info->free_memory * 64 * KiB - kend);
+        return;
+    }
+
+    // the heap has to be set up first, as everything else is added to it
+    int found = 0;
+    for (int i = 0; i < start_info->memory_map_entries; i++) {
+        struct e820_entry* entry = &start_info->memory_map[i];
+        uint64_t end = MIN(entry->base + entry->length, 0x100000000ull);
+        if (entry->type == E820_TYPE_USABLE && entry->base <= kend && kend < end) {
+            init_alloc(start_info->memory_start, end - kend);
+            found = 1;
+            break;
+        }
+    }
+    ASSERT(found, "Kernel was not loaded into usable memory");
+
+    for (int i = 0; i < start_info->memory_map_entries; i++) {
+        struct e820_entry* entry = &start_info->memory_map[i];
+        if (entry->type != E820_TYPE_USABLE)
+            continue;
+
+        // low memory is left for the BIOS, and we can only address 4 GiB
+        uint64_t base = MAX(entry->base, 1 * MiB);
+        uint64_t end = MIN(entry->base + entry->length, 0x100000000ull);
+        if (base >= end)
+            continue;
+
+        // the kernel and the heap after it are already taken care of
+        if (base < kend && kstart < end) {
+            if (base < kstart)
+                alloc_add_region((void*)(uint32_t)base, kstart - base);
+            continue;
+        }
+
+        alloc_add_region((void*)(uint32_t)base, end - base);
+    }
+}
+
 extern int _kexp_start, _kexp_end;
 void kernel_main(struct kstart_info* start_info)
 {
@@ -246,9 +303,11 @@ void kernel_main(struct kstart_info* start_info)
     dbgout = NULL;
     console = NULL;
 
+    memops_init();
+    simd_init();
     interrupts_init();
     gdt_init();
-    init_alloc(start_info->memory_start, start_info->free_memory * 64 * KiB);
+    init_memory(start_info);
 
     driver_init();
     mod_init();
@@ -260,6 +319,8 @@ void kernel_main(struct kstart_info* start_info)
 
     dbgout = device_get_chardev(device_get_by_name("sp0")); // TODO: get first avail chardev?
     debug("debug serial up");
+    debugf("using %s memory operations", memops_describe());
+    debugf("SIMD %s", simd_enabled ? "enabled" : "disabled");
 
     mod_ksymtab_add(ksymtab, ksymtab_size);
 
@@ -267,7 +328,7 @@ void kernel_main(struct kstart_info* start_info)
 
     // setup a VGA console for early init. will be replaced later if we want
     console = device_get_console(device_get_by_name("vga0"));
-    stdout = kalloc(sizeof(*stdout));
+    stdout = chardev_alloc();
     console_get_chardev(console, stdout);
     debug("early vga console initialised");
 
@@ -275,7 +336,7 @@ void kernel_main(struct kstart_info* start_info)
     debug("syscalls initialised");
 
     keyboard_init();
-    stdin = kalloc(sizeof(*stdin));
+    stdin = chardev_alloc();
     keyboard_get_chardev(stdin);
     debug("keyboard initialised");
 
@@ -11,10 +11,28 @@ void hang();
 void hlt();
 void yield();
 
+// The most entries of the BIOS memory map which are passed to the kernel. This
+// must match MEMORY_MAP_MAX in stage2.S
+#define E820_MAX_ENTRIES    32
+// Memory map entry type for memory which is free to use
+#define E820_TYPE_USABLE    1
+
+// An entry in the memory map returned by INT 15h, EAX=E820h
+struct e820_entry {
+    uint64_t base;
+    uint64_t length;
+    uint32_t type;
+    uint32_t acpi_attrs;
+} __attribute__((packed));
+
 struct kstart_info {
     uint8_t drive_number;
     uint32_t free_memory;
     void* memory_start;
+    // the BIOS memory map, memory_map_entries is zero if the BIOS didn't give
+    // us one
+    uint32_t memory_map_entries;
+    struct e820_entry memory_map[E820_MAX_ENTRIES];
 };
 
 #define KERNEL_CSEL     0x08
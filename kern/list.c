@@ -1,7 +1,9 @@
 #include <stddef.h>
 #include "stdlib.h"
 #include "list.h"
-#include "alloc.h"
+#include "slab.h"
+
+static slab_cache_t node_cache = SLAB_CACHE_INIT("list_node", sizeof(struct list_node));
 
 void list_init(struct list* list)
 {
@@ -45,7 +47,7 @@ void list_append(struct list* list, struct list_node* item)
  */
 struct list_node* list_node(void* data)
 {
-    struct list_node* node = kalloc(sizeof(*node));
+    struct list_node* node = slab_alloc(&node_cache);
     node->value = data;
     return node;
 }
@@ -74,7 +76,7 @@ void list_remove(struct list_node* item)
     prev->next = next;
     next->prev = prev;
 
-    kfree(item);
+    slab_free(&node_cache, item);
 }
 
 /**
@@ -13,22 +13,27 @@
 #include "env.h"
 #include "stddef.h"
 #include "alloc.h"
+#include "arena.h"
+#include "slab.h"
 #include "printf.h"
 #include "sys/cpuid.h"
 #include "exe/elf.h"
 #include "mod.h"
 #include "version.h"
 #include "selftest.h"
+#include "allocbench.h"
+#include "membench.h"
+#include "cksumbench.h"
 #include "config.h"
 #include "io/conlib.h"
+#include "cmd.h"
 
 char main_scratch[64];
 char current_dir[256];
 
-struct command {
-    const char* name;
-    void (*fn)(int, char**);
-};
+// size of the on-stack scratch space used while processing a command, anything
+// beyond this spills over onto the heap
+#define CMD_SCRATCH_SIZE    256
 
 const char* colours[] = {
     "black",
@@ -207,6 +212,10 @@ void help(int argc, char** argv)
     puts("Help Summary. WIP commands marked with [WIP] or if very unstable, not listed.\n");
     puts("uptime      - display uptime in seconds\n");
     puts("mem         - get memory status\n");
+    puts("heapstat    - get detailed heap statistics\n");
+    puts("slabinfo    - get object cache statistics\n");
+    puts("allocbench  - benchmark the memory allocator\n");
+    puts("bench       - run a benchmark (mem, alloc or cksum)\n");
     puts("cpuid       - display CPU info\n");
     puts("brk         - cause a #BP interrupt\n");
     puts("clear       - clear the display\n");
@@ -317,6 +326,73 @@ void mem(int argc, char** argv)
     printf("Total     = %d bytes\n", total);
 }
 
+void heapstat(int argc, char** argv)
+{
+    if (argc == 2 && strcmp(argv[1], "dump") == 0) {
+        kdumpstats();
+        return;
+    } else if (argc == 3 && strcmp(argv[1], "track") == 0) {
+        alloc_track_callers(strcmp(argv[2], "on") == 0);
+        return;
+    } else if (argc != 1) {
+        printf("Usage: %s [dump | track on|off]\n", argv[0]);
+        return;
+    }
+
+    struct alloc_stats stats;
+    alloc_get_stats(&stats);
+
+    printf("Live      = %d bytes in %d allocations\n", stats.live_bytes, stats.live_allocs);
+    printf("Peak      = %d bytes\n", stats.peak_bytes);
+    printf("Allocs    = %d (%d frees)\n", stats.total_allocs, stats.total_frees);
+    printf("Heap      = %d blocks, %d bytes free, largest %d (%d%% fragmented)\n",
+        stats.heap_blocks, stats.heap_free_bytes, stats.heap_largest_free,
+        stats.heap_fragmentation);
+    printf("Pages     = %d bytes free, largest %d (%d%% fragmented)\n",
+        stats.page_free_bytes, stats.page_largest_free,
+        stats.page_fragmentation);
+
+    printf("Sizes:\n");
+    for (int i = 0; i < MEM_HIST_BUCKETS; i++) {
+        if (!stats.histogram[i])
+            continue;
+        if (i == MEM_HIST_BUCKETS - 1)
+            printf("  > %7d  %d\n", 16 << (i - 1), stats.histogram[i]);
+        else
+            printf("  <= %6d  %d\n", 16 << i, stats.histogram[i]);
+    }
+
+    size_t count;
+    const struct alloc_callsite* sites = alloc_callsites(&count);
+    if (count) {
+        printf("Callers:\n");
+        for (size_t i = 0; i < count; i++)
+            printf("  %08x  %d allocs, %d bytes\n", sites[i].caller, sites[i].allocs, sites[i].bytes);
+        if (stats.untracked_allocs)
+            printf("  (%d allocs from other callers)\n", stats.untracked_allocs);
+    }
+}
+
+static void slabinfo_callback(slab_cache_t* cache)
+{
+    printf("%-12s %6d %6d %6d %6d %10d %10d\n",
+        cache->name,
+        cache->obj_size,
+        cache->num_slabs,
+        cache->in_use,
+        cache->peak_in_use,
+        cache->total_allocs,
+        cache->total_frees
+    );
+}
+
+void slabinfo(int argc, char** argv)
+{
+    printf("%-12s %6s %6s %6s %6s %10s %10s\n",
+        "cache", "size", "slabs", "inuse", "peak", "allocs", "frees");
+    slab_foreach(slabinfo_callback);
+}
+
 void ldmod(int argc, char** argv)
 {
     if (argc != 2) {
@@ -571,6 +647,19 @@ void sysinfo(int argc, char** argv)
     display_sysinfo();
 }
 
+void bench(int argc, char** argv)
+{
+    if (argc >= 2 && strcmp(argv[1], "mem") == 0) {
+        membench(argc - 1, argv + 1);
+    } else if (argc >= 2 && strcmp(argv[1], "alloc") == 0) {
+        allocbench(argc - 1, argv + 1);
+    } else if (argc >= 2 && strcmp(argv[1], "cksum") == 0) {
+        cksumbench(argc - 1, argv + 1);
+    } else {
+        printf("Usage: %s mem|alloc|cksum [args]\n", argv[0]);
+    }
+}
+
 
 
 static struct command commands[] = {
@@ -583,6 +672,8 @@ static struct command commands[] = {
     {"endrv", endrv},
     {"uptime", uptime},
     {"mem", mem},
+    {"slabinfo", slabinfo},
+    {"heapstat", heapstat},
     {"ver", ver},
     {"cpuid", cmd_cpuid},
     {"clear", clear},
@@ -608,22 +699,11 @@ static struct command commands[] = {
     {"logo", logo},
     {"sysinfo", sysinfo},
     {"selftest", selftest},
+    {"allocbench", allocbench},
+    {"bench", bench},
     {"setscheme", setscheme},
 };
 
-// Invoke a shell-internal function. Returns a non-zero value if a function
-// was invoked; zero otherwise.
-int invoke_internal(const char* name, int argc, char** argv)
-{
-    for (int i = 0; i < sizeof(commands) / sizeof(struct command); i++) {
-        if (strcmp(commands[i].name, name) == 0) {
-            commands[i].fn(argc, argv);
-            return 1;
-        }
-    }
-    return 0;
-}
-
 // Invoke a shell-external program. Returns a non-zero value if the program
 // was invoked; zero otherwise.
 int invoke_external(const char* name, int argc, char** argv)
@@ -666,26 +746,19 @@ void process_command_string(char* cmdbuf)
     if (cmdbuf[0] == '\0')
         return;
 
-    int argc = 1;
-    char* token = strtok(cmdbuf, " ");
-    while (strtok(NULL, " ") != NULL) { argc++; }
-
-    char** argv = kalloc(sizeof(char*) * argc);
-
-    char* tmp = token;
-    for (int i = 0; i < argc; i++) {
-        argv[i] = tmp;
-        tmp += strlen(tmp) + 1;
-    }
+    ARENA_ON_STACK(scratch, CMD_SCRATCH_SIZE);
+    char** argv;
+    int argc = cmd_split(cmdbuf, &scratch, &argv);
 
     if (
-        !invoke_internal(token, argc, argv)
-        && !invoke_external(token, argc, argv)
+        argc > 0
+        && !cmd_invoke(argc, argv)
+        && !invoke_external(argv[0], argc, argv)
     ) {
-        printf("? %s\n", cmdbuf);
+        printf("? %s\n", argv[0]);
     }
 
-    kfree(argv);
+    arena_destroy(&scratch);
 }
 
 void process_autorun()
@@ -727,11 +800,13 @@ void process_autorun()
 void main()
 {
     char cmdbuf[256];
+    config_handle_t prompt = config_lookup("sys:prompt");
 
+    cmd_register_table(commands, sizeof(commands) / sizeof(struct command));
     process_autorun();
 
     while (1) {
-        puts(config_getstrns("sys", "prompt"));
+        puts(config_handle_getstr(prompt));
         gets(cmdbuf);
 
         if (*cmdbuf) {
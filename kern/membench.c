@@ -0,0 +1,228 @@
+/**
+ * @file membench.c
+ * @brief Memory operations benchmark
+ *
+ * Times memcpy, memset, memcmp and memblit over a range of sizes and
+ * alignments, along with every variant of memcpy and memset the CPU supports.
+ * A summary is printed to the screen, and every measurement is written to the
+ * debug serial port as a comma separated table, so that runs on different
+ * builds or machines can be compared.
+ */
+
+#include "membench.h"
+
+#include <stdint.h>
+#include "stdlib.h"
+#include "alloc.h"
+#include "bench.h"
+#include "version.h"
+
+#define MEMBENCH_MIN_SIZE       16
+#define MEMBENCH_MAX_SIZE       (4 * MiB)
+// each measurement processes at least this much memory in total, so that the
+// small sizes are repeated enough to be timed accurately
+#define MEMBENCH_MIN_TOTAL      (4 * MiB)
+// memblit copies rows of at most this many bytes
+#define MEMBENCH_BLIT_WIDTH     1024
+// space for memblit's gap between rows, and the alignment offsets
+#define MEMBENCH_BUF_SIZE(max)  ((max) + (max) / 8 + 64)
+
+#define MEMBENCH_NUM_ALIGNMENTS 4
+
+// source and destination offsets from a 64 byte boundary
+static const int alignments[MEMBENCH_NUM_ALIGNMENTS][2] = {
+    {0, 0}, {1, 0}, {0, 3}, {5, 13}
+};
+
+static void run_copy(const struct memops_impl* impl, uint8_t* dst, uint8_t* src, size_t size)
+{
+    impl->copy(dst, src, size);
+}
+
+static void run_set(const struct memops_impl* impl, uint8_t* dst, uint8_t* src, size_t size)
+{
+    impl->fill(dst, 0x5a, size);
+}
+
+static void run_cmp(const struct memops_impl* impl, uint8_t* dst, uint8_t* src, size_t size)
+{
+    // the buffers are identical, so the whole size is compared
+    memcmp(dst, src, size);
+}
+
+static void run_blit(const struct memops_impl* impl, uint8_t* dst, uint8_t* src, size_t size)
+{
+    // a rectangle in a buffer with some space between rows, as a window on a
+    // framebuffer would be
+    size_t width = MIN(size, MEMBENCH_BLIT_WIDTH);
+    size_t height = size / width;
+    memblit(dst, src, width + width / 8, height, 1, 0, 0, width, height);
+}
+
+struct membench_op {
+    const char* name;
+    void (*run)(const struct memops_impl* impl, uint8_t* dst, uint8_t* src, size_t size);
+    // whether each memops variant should be run, rather than just the default
+    int per_impl;
+};
+
+static struct membench_op ops[] = {
+    {"copy", run_copy, 1},
+    {"set", run_set, 1},
+    {"cmp", run_cmp, 0},
+    {"blit", run_blit, 0},
+};
+
+// the variant the kernel has picked for itself
+static struct memops_impl default_impl = { "auto", memcpy, memset };
+
+static struct membench_op* find_op(const char* name)
+{
+    for (int i = 0; i < sizeof(ops) / sizeof(struct membench_op); i++) {
+        if (strcmp(name, ops[i].name) == 0)
+            return &ops[i];
+    }
+    return NULL;
+}
+
+static const struct memops_impl* find_impl(const char* name)
+{
+    if (strcmp(name, default_impl.name) == 0)
+        return &default_impl;
+
+    const struct memops_impl* impls;
+    int num_impls = memops_get_impls(&impls);
+    for (int i = 0; i < num_impls; i++) {
+        if (strcmp(name, impls[i].name) == 0)
+            return &impls[i];
+    }
+    return NULL;
+}
+
+struct membench_result {
+    uint32_t mib_per_sec;
+    // cycles per byte, multiplied by 100
+    uint32_t cycles_per_byte;
+};
+
+static void measure(struct membench_op* op, const struct memops_impl* impl,
+        uint8_t* dst, uint8_t* src, size_t size, struct membench_result* result)
+{
+    uint32_t reps = MAX(MEMBENCH_MIN_TOTAL / size, 1u);
+    uint32_t total = reps * size;
+
+    // once first, so everything starts off in the same state
+    op->run(impl, dst, src, size);
+
+    uint64_t start = rdtsc();
+    for (uint32_t i = 0; i < reps; i++)
+        op->run(impl, dst, src, size);
+    uint64_t cycles = rdtsc() - start;
+
+    result->mib_per_sec = bench_per_sec(total / KiB, cycles) / KiB;
+    result->cycles_per_byte = bench_div64(cycles * 100, total);
+}
+
+static void bench_op_impl(struct membench_op* op, const struct memops_impl* impl,
+        uint8_t* dst_buf, uint8_t* src_buf, size_t max_size)
+{
+    for (size_t size = MEMBENCH_MIN_SIZE; size <= max_size; size *= 4) {
+        struct membench_result results[MEMBENCH_NUM_ALIGNMENTS];
+
+        for (int i = 0; i < MEMBENCH_NUM_ALIGNMENTS; i++) {
+            uint8_t* src = src_buf + alignments[i][0];
+            uint8_t* dst = dst_buf + alignments[i][1];
+            memcpy(dst, src, size);
+            measure(op, impl, dst, src, size, &results[i]);
+
+            dprintf_raw("membench,%s,%s,%d,%d,%d,%d,%d.%02d\n",
+                op->name, impl->name, size, alignments[i][0], alignments[i][1],
+                results[i].mib_per_sec,
+                results[i].cycles_per_byte / 100, results[i].cycles_per_byte % 100);
+        }
+
+        printf("%-5s %-7s %8d %6d %6d %6d %6d %4d.%02d\n",
+            op->name, impl->name, size,
+            results[0].mib_per_sec, results[1].mib_per_sec,
+            results[2].mib_per_sec, results[3].mib_per_sec,
+            results[0].cycles_per_byte / 100, results[0].cycles_per_byte % 100);
+    }
+}
+
+/**
+ * @brief Benchmark the memory operations
+ *
+ * Usage: mem [op] [variant], where op is one of copy, set, cmp or blit, and
+ * variant is one of the memcpy/memset variants, or auto.
+ */
+void membench(int argc, char** argv)
+{
+    if (!bench_available()) {
+        printf("No timestamp counter, can't benchmark\n");
+        return;
+    }
+
+    const struct memops_impl* impls;
+    int num_impls = memops_get_impls(&impls);
+
+    struct membench_op* only_op = NULL;
+    const struct memops_impl* only_impl = NULL;
+    for (int i = 1; i < argc; i++) {
+        struct membench_op* op = find_op(argv[i]);
+        const struct memops_impl* impl = find_impl(argv[i]);
+        if (op) {
+            only_op = op;
+        } else if (impl) {
+            only_impl = impl;
+        } else {
+            printf("Usage: %s [copy|set|cmp|blit] [auto", argv[0]);
+            for (int j = 0; j < num_impls; j++)
+                printf("|%s", impls[j].name);
+            printf("]\n");
+            return;
+        }
+    }
+
+    // two buffers, each rounded up to a power of two pages, have to fit
+    struct alloc_stats stats;
+    alloc_get_stats(&stats);
+    size_t max_size = MEMBENCH_MAX_SIZE;
+    while (max_size > 64 * KiB && MEMBENCH_BUF_SIZE(max_size) * 4 > stats.page_largest_free)
+        max_size /= 2;
+
+    uint8_t* src_buf = kalloc(MEMBENCH_BUF_SIZE(max_size));
+    uint8_t* dst_buf = kalloc(MEMBENCH_BUF_SIZE(max_size));
+    for (size_t i = 0; i < MEMBENCH_BUF_SIZE(max_size); i++)
+        src_buf[i] = i * 7;
+
+    uint32_t khz = bench_tsc_khz();
+    printf("TSC at %d kHz, using %s, up to %d bytes\n", khz, memops_describe(), max_size);
+    printf("%-5s %-7s %8s %27s %7s\n", "op", "variant", "size", "MiB/s at src/dst offset", "cyc/B");
+    printf("%-5s %-7s %8s %6s %6s %6s %6s\n", "", "", "", "0/0", "1/0", "0/3", "5/13");
+
+    dprintf_raw("# membench " VER_GIT_REV " " VER_GIT_BRANCH ", tsc %d kHz, %s\n",
+        khz, memops_describe());
+    dprintf_raw("membench,op,variant,size,src_offset,dst_offset,mib_per_sec,cycles_per_byte\n");
+
+    for (int i = 0; i < sizeof(ops) / sizeof(struct membench_op); i++) {
+        if (only_op && only_op != &ops[i])
+            continue;
+
+        if (!only_impl || only_impl == &default_impl)
+            bench_op_impl(&ops[i], &default_impl, dst_buf, src_buf, max_size);
+
+        if (!ops[i].per_impl)
+            continue;
+
+        for (int j = 0; j < num_impls; j++) {
+            if (only_impl && only_impl != &impls[j])
+                continue;
+            if (ops[i].run == run_set && !impls[j].fill)
+                continue;
+            bench_op_impl(&ops[i], &impls[j], dst_buf, src_buf, max_size);
+        }
+    }
+
+    kfree(src_buf);
+    kfree(dst_buf);
+}
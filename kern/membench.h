@@ -0,0 +1,3 @@
+#pragma once
+
+void membench(int argc, char** argv);
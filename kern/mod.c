@@ -9,9 +9,14 @@
 #include "exe/elf.h"
 #include "printf.h"
 #include "alloc.h"
+#include "htbl.h"
+#include "intern.h"
 
 static struct list exports;
 static struct list modules;
+// index of `exports` by interned name, the first exported wins if several
+// share a name
+static htbl_t* exports_by_name;
 
 
 /**
@@ -22,11 +27,15 @@ void mod_init()
 {
     list_init(&exports);
     list_init(&modules);
+    exports_by_name = htbl_create_flags(HTBL_INTERN_KEYS);
 }
 
 static void module_sym_add(struct symbol* sym)
 {
     list_append(&exports, list_node(sym));
+    const char* name = intern(sym->name);
+    if (!htbl_get_interned(exports_by_name, name))
+        htbl_put_interned(exports_by_name, name, sym);
 }
 
 /**
@@ -95,7 +104,7 @@ void mod_symtab_add(void* base, void* symtab, size_t szsymtab)
         // Apply relocations
         sym->name += (uint32_t)base;
         sym->fn += (uint32_t)base;
-        list_append(&exports, list_node(sym));
+        module_sym_add(sym);
     }
 }
 
@@ -131,14 +140,13 @@ void mod_sym_list()
  */
 void* mod_sym_get(const char* name)
 {
-    struct list_node* current = &exports.head;
-    while ((current = list_next(current)) && current->next) {
-        struct symbol* sym = current->value;
-        if (strcmp(sym->name, name) == 0)
-            return sym->fn;
-    }
+    // a name which was never interned can't have been exported
+    const char* interned = intern_lookup(name);
+    if (!interned)
+        return NULL;
 
-    return NULL;
+    struct symbol* sym = htbl_get_interned(exports_by_name, interned);
+    return sym ? sym->fn : NULL;
 }
 
 /**
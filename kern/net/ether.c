@@ -1,5 +1,6 @@
 #include "ether.h"
 #include "../stdlib.h"
+#include "../cksum.h"
 
 void* ether_make_packet(void* buffer, uint8_t* src, uint8_t* dst, uint16_t length)
 {
@@ -19,5 +20,14 @@ size_t ether_buffer_length(size_t data_size)
 
 void ether_calc_crc(void* buffer, size_t data_size)
 {
+    // short frames are padded out with zeros, which the CRC covers
+    size_t padded_size = data_size > 48 ? data_size : 48;
+    uint8_t* data = buffer + sizeof(ether_header_t);
+    memset(data + data_size, 0, padded_size - data_size);
 
+    // the frame check sequence goes after the data, least significant byte
+    // first
+    size_t frame_size = sizeof(ether_header_t) + padded_size;
+    uint32_t crc = crc32(CRC32_INIT, buffer, frame_size);
+    memcpy(buffer + frame_size, &crc, sizeof(crc));
 }
\ No newline at end of file
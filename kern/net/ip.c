@@ -1,4 +1,5 @@
 #include "ip.h"
+#include "../cksum.h"
 
 void* ip_make_packet(void* packet, size_t data_length, uint8_t protocol, uint32_t src, uint32_t dst)
 {
@@ -19,6 +20,9 @@ void* ip_make_packet(void* packet, size_t data_length, uint8_t protocol, uint32_
     header->protocol = protocol;
     header->src_ip = src;
     header->dst_ip = dst;
+
+    header->header_cksum = 0;
+    header->header_cksum = cksum_inet(packet, sizeof(ipv4_header_t));
     return packet + sizeof(ipv4_header_t);
 }
 
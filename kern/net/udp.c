@@ -1,4 +1,5 @@
 #include "udp.h"
+#include "../cksum.h"
 
 void* udp_make_packet(void* packet, size_t data_length, uint16_t src_port, uint16_t dst_port)
 {
@@ -6,10 +7,33 @@ void* udp_make_packet(void* packet, size_t data_length, uint16_t src_port, uint1
     header->src_port = src_port;
     header->dst_port = dst_port;
     header->length = data_length + sizeof(udp_header_t);
-    header->cksum = 0; // Checksum is optional, so we ignore it
+    header->cksum = 0; // Filled in by udp_calc_cksum once the data is there
     return packet + sizeof(udp_header_t);
 }
 
+void udp_calc_cksum(void* packet, uint32_t src_ip, uint32_t dst_ip)
+{
+    udp_header_t* header = (udp_header_t*)packet;
+    uint16_t length = header->length;
+
+    // the pseudo-header is laid out in network order by hand, since the
+    // address of a reverse storage order struct can't be taken to sum it
+    uint8_t pseudo[UDP_PSEUDO_HEADER_LEN] = {
+        src_ip >> 24, src_ip >> 16, src_ip >> 8, src_ip,
+        dst_ip >> 24, dst_ip >> 16, dst_ip >> 8, dst_ip,
+        0, UDP_PROTOCOL, length >> 8, length,
+    };
+
+    header->cksum = 0;
+    uint32_t sum = cksum_ones(0, pseudo, sizeof(pseudo));
+    sum = cksum_ones(sum, packet, length);
+
+    // zero means no checksum was calculated, so a checksum that really is zero
+    // is sent as its one's complement equivalent instead
+    uint16_t cksum = cksum_inet_fold(sum);
+    header->cksum = cksum ? cksum : 0xffff;
+}
+
 size_t udp_buffer_length(size_t data_length)
 {
     return data_length + sizeof(udp_header_t);
@@ -10,8 +10,16 @@ typedef struct {
     uint16_t cksum;
 } __attribute__((packed, scalar_storage_order("big-endian"))) udp_header_t;
 
+#define UDP_PROTOCOL    17
+
+// Length of the part of the IPv4 header covered by the UDP checksum
+#define UDP_PSEUDO_HEADER_LEN   12
+
 // Takes a raw buffer and returns the address at which payload data may be added,
 void* udp_make_packet(void* packet, size_t data_length, uint16_t src_port, uint16_t dst_port);
 
 // Returns the size required for a buffer given a data length
-size_t udp_buffer_length(size_t data_length);
\ No newline at end of file
+size_t udp_buffer_length(size_t data_length);
+
+// Calculates the checksum of a UDP packet, once its data has been filled in
+void udp_calc_cksum(void* packet, uint32_t src_ip, uint32_t dst_ip);
\ No newline at end of file
@@ -0,0 +1,299 @@
+/**
+ * @file page.c
+ * @brief Buddy allocator for page-sized (and larger) memory
+ *
+ * Memory is handed out in blocks of a power of two number of pages. A block
+ * which is larger than needed is split in half repeatedly, and when a block is
+ * freed it is merged with its "buddy" (the other half of the block it was
+ * split from) for as long as that buddy is also free. Every block is therefore
+ * page aligned, and freed memory always comes back together into large blocks
+ * rather than fragmenting.
+ *
+ * Memory can be made up of several separate regions. The state of the pages
+ * in each is kept in a byte per page at the start of the region, so blocks
+ * themselves carry no header. Blocks never span regions, but the free lists
+ * are shared between them.
+ */
+
+#include "page.h"
+#include "stdlib.h"
+#include "kernel.h"
+#include <export.h>
+
+static struct page_region regions[PAGE_MAX_REGIONS];
+static int num_regions = 0;
+static size_t pages_used = 0;
+
+// free blocks of each order
+static struct page_free_links* free_lists[PAGE_MAX_ORDER + 1];
+
+static void* page_addr(struct page_region* region, size_t index)
+{
+    return region->start + (index << PAGE_SHIFT);
+}
+
+static size_t page_index(struct page_region* region, void* ptr)
+{
+    return ((uint8_t*)ptr - region->start) >> PAGE_SHIFT;
+}
+
+// the region containing an address, or NULL if it isn't in any region
+static struct page_region* region_of(void* ptr)
+{
+    for (int i = 0; i < num_regions; i++) {
+        struct page_region* region = &regions[i];
+        if ((uint8_t*)ptr >= region->start
+                && (uint8_t*)ptr < region->start + (region->num_pages << PAGE_SHIFT))
+            return region;
+    }
+    return NULL;
+}
+
+static void free_push(struct page_region* region, size_t index, int order)
+{
+    struct page_free_links* links = page_addr(region, index);
+    links->prev = NULL;
+    links->next = free_lists[order];
+    if (free_lists[order])
+        free_lists[order]->prev = links;
+    free_lists[order] = links;
+
+    region->info[index] = PAGE_INFO_HEAD | PAGE_INFO_FREE | order;
+}
+
+static void free_remove(struct page_region* region, size_t index, int order)
+{
+    struct page_free_links* links = page_addr(region, index);
+    if (links->prev)
+        links->prev->next = links->next;
+    else
+        free_lists[order] = links->next;
+
+    if (links->next)
+        links->next->prev = links->prev;
+}
+
+/**
+ * @brief Initialise the page allocator
+ *
+ * @param start the start of contiguous free memory
+ * @param size the number of free bytes following the start
+ */
+void page_init(void* start, size_t size)
+{
+    for (int i = 0; i <= PAGE_MAX_ORDER; i++)
+        free_lists[i] = NULL;
+    num_regions = 0;
+    pages_used = 0;
+
+    page_add_region(start, size);
+}
+
+/**
+ * @brief Give another region of free memory to the page allocator
+ *
+ * @param start the start of contiguous free memory
+ * @param size the number of free bytes following the start
+ */
+void page_add_region(void* start, size_t size)
+{
+    // the page information goes first, with the pages themselves following
+    // it from the first page boundary
+    uintptr_t end = (uintptr_t)start + size;
+    size_t max_pages = size / (PAGE_SIZE + 1);
+    uintptr_t first = ((uintptr_t)start + max_pages + PAGE_SIZE - 1) & ~(uintptr_t)(PAGE_SIZE - 1);
+    size_t num_pages = first < end ? (end - first) >> PAGE_SHIFT : 0;
+
+    if (!num_pages)
+        return;
+    if (num_regions == PAGE_MAX_REGIONS) {
+        logf(LOG_WARN, "too many memory regions, ignoring %d KiB at %08x", size / KiB, start);
+        return;
+    }
+
+    struct page_region* region = &regions[num_regions++];
+    region->info = start;
+    region->start = (uint8_t*)first;
+    region->num_pages = num_pages;
+    memset(region->info, 0, num_pages);
+
+    // divide the pages up into the largest blocks possible. a block's index
+    // must be a multiple of its size, so that its buddy can always be found
+    size_t index = 0;
+    while (index < num_pages) {
+        int order = index ? __builtin_ctz(index) : PAGE_MAX_ORDER;
+        order = MIN(order, PAGE_MAX_ORDER);
+        while (index + (1u << order) > num_pages)
+            order--;
+
+        free_push(region, index, order);
+        index += 1u << order;
+    }
+}
+
+/**
+ * @brief Allocate a block of pages.
+ *
+ * @param size the size to allocate, in bytes. will be rounded up to a power of
+ * two number of pages
+ * @return void* a page aligned pointer to the allocated memory, or NULL if
+ * there is no block large enough
+ */
+void* page_alloc(size_t size)
+{
+    int order = 0;
+    while (order <= PAGE_MAX_ORDER && ((size_t)PAGE_SIZE << order) < size)
+        order++;
+
+    int current = order;
+    while (current <= PAGE_MAX_ORDER && !free_lists[current])
+        current++;
+    if (current > PAGE_MAX_ORDER)
+        return NULL;
+
+    struct page_region* region = region_of(free_lists[current]);
+    size_t index = page_index(region, free_lists[current]);
+    free_remove(region, index, current);
+
+    // give back the upper half of the block until it's the right size
+    while (current > order) {
+        current--;
+        free_push(region, index + (1u << current), current);
+    }
+
+    region->info[index] = PAGE_INFO_HEAD | order;
+    pages_used += 1u << order;
+    return page_addr(region, index);
+}
+EXPORT_SYM(page_alloc);
+
+/**
+ * @brief Free a block of pages
+ *
+ * @param ptr a pointer to the block, as returned by page_alloc
+ */
+void page_free(void* ptr)
+{
+    ASSERT(page_block_size(ptr), "Tried to free invalid page block");
+    struct page_region* region = region_of(ptr);
+    size_t index = page_index(region, ptr);
+    ASSERT(!(region->info[index] & PAGE_INFO_CRITICAL), "Tried to free critical memory");
+
+    int order = region->info[index] & PAGE_INFO_ORDER;
+    pages_used -= 1u << order;
+
+    while (order < PAGE_MAX_ORDER) {
+        size_t buddy = index ^ (1u << order);
+        if (buddy >= region->num_pages
+                || region->info[buddy] != (PAGE_INFO_HEAD | PAGE_INFO_FREE | order))
+            break;
+
+        free_remove(region, buddy, order);
+        // the merged block starts at whichever of the two comes first, so the
+        // other is no longer the head of anything
+        region->info[MAX(index, buddy)] = 0;
+        index = MIN(index, buddy);
+        order++;
+    }
+
+    free_push(region, index, order);
+}
+EXPORT_SYM(page_free);
+
+/**
+ * @brief Check whether an address is within the memory managed by the page
+ * allocator.
+ *
+ * @param ptr the address to check
+ * @return int non-zero if the address is managed by the page allocator
+ */
+int page_owns(void* ptr)
+{
+    return region_of(ptr) != NULL;
+}
+
+/**
+ * @brief Get the size of an allocated block of pages.
+ *
+ * @param ptr a pointer to the block
+ * @return size_t the size of the block in bytes, or zero if ptr is not the
+ * start of an allocated block
+ */
+size_t page_block_size(void* ptr)
+{
+    struct page_region* region = region_of(ptr);
+    if (!region || ((uintptr_t)ptr & (PAGE_SIZE - 1)))
+        return 0;
+
+    uint8_t info = region->info[page_index(region, ptr)];
+    if (!(info & PAGE_INFO_HEAD) || (info & PAGE_INFO_FREE))
+        return 0;
+
+    return (size_t)PAGE_SIZE << (info & PAGE_INFO_ORDER);
+}
+
+/**
+ * @brief Mark a block as critical. Attempts to free it will fault
+ *
+ * @param ptr a pointer to the block
+ */
+void page_mark_critical(void* ptr)
+{
+    ASSERT(page_block_size(ptr), "Tried to mark as critical an invalid page block");
+    struct page_region* region = region_of(ptr);
+    region->info[page_index(region, ptr)] |= PAGE_INFO_CRITICAL;
+}
+
+/**
+ * @brief Get the amount of memory currently allocated as pages
+ *
+ * @return size_t the amount of memory in use, in bytes
+ */
+size_t page_used()
+{
+    return pages_used << PAGE_SHIFT;
+}
+
+/**
+ * @brief Get the total amount of memory managed by the page allocator
+ *
+ * @return size_t the total amount of memory, in bytes
+ */
+size_t page_total()
+{
+    size_t total = 0;
+    for (int i = 0; i < num_regions; i++)
+        total += regions[i].num_pages;
+    return total << PAGE_SHIFT;
+}
+
+/**
+ * @brief Get the size of the largest free block of pages
+ *
+ * @return size_t the size of the largest free block, in bytes
+ */
+size_t page_largest_free()
+{
+    for (int order = PAGE_MAX_ORDER; order >= 0; order--) {
+        if (free_lists[order])
+            return (size_t)PAGE_SIZE << order;
+    }
+    return 0;
+}
+
+/**
+ * @brief Dump page allocator info, only for debugging
+ */
+void page_dump()
+{
+    debugf("pages: %d total, %d used", page_total() >> PAGE_SHIFT, pages_used);
+    for (int i = 0; i < num_regions; i++)
+        debugf("region %d: %d pages at %08x", i, regions[i].num_pages, regions[i].start);
+    for (int order = 0; order <= PAGE_MAX_ORDER; order++) {
+        int count = 0;
+        for (struct page_free_links* current = free_lists[order]; current; current = current->next)
+            count++;
+        if (count)
+            debugf("order %02d (%d KiB): %d free", order, (PAGE_SIZE << order) / KiB, count);
+    }
+}
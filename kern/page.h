@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PAGE_SIZE           4096
+#define PAGE_SHIFT          12
+// The largest block handed out by the page allocator is 2^PAGE_MAX_ORDER pages
+#define PAGE_MAX_ORDER      16
+
+// Each page has a byte of information, which is only meaningful for the first
+// page of a block. The low bits hold the block's order
+#define PAGE_INFO_ORDER     0x1f
+#define PAGE_INFO_HEAD      (1 << 5)
+#define PAGE_INFO_FREE      (1 << 6)
+#define PAGE_INFO_CRITICAL  (1 << 7)
+
+// The most separate regions of memory the page allocator can manage
+#define PAGE_MAX_REGIONS    16
+
+// A contiguous region of memory managed by the page allocator
+struct page_region {
+    // the first page in the region
+    uint8_t* start;
+    size_t num_pages;
+    // one byte of information per page, see PAGE_INFO_*
+    uint8_t* info;
+};
+
+// Links for the free lists of each order. These occupy the start of the first
+// page of a free block
+struct page_free_links {
+    struct page_free_links* next;
+    struct page_free_links* prev;
+};
+
+void page_init(void* start, size_t size);
+void page_add_region(void* start, size_t size);
+void* page_alloc(size_t size);
+void page_free(void* ptr);
+int page_owns(void* ptr);
+size_t page_block_size(void* ptr);
+void page_mark_critical(void* ptr);
+size_t page_used();
+size_t page_total();
+size_t page_largest_free();
+void page_dump();
@@ -58,6 +58,13 @@
 #define PRINTF_FTOA_BUFFER_SIZE    32U
 #endif
 
+// size of the buffer printf() formats into before writing to stdout in one go,
+// created on the stack
+// default: 128 byte
+#ifndef PRINTF_OUT_BUFFER_SIZE
+#define PRINTF_OUT_BUFFER_SIZE    128U
+#endif
+
 // support for the floating point type (%f)
 // default: activated
 #ifndef PRINTF_DISABLE_SUPPORT_FLOAT
@@ -155,6 +162,36 @@ static inline void _out_char(char character, void* buffer, size_t idx, size_t ma
 }
 
 
+// buffer for output to stdout, which is written a chunk at a time
+typedef struct {
+  char   data[PRINTF_OUT_BUFFER_SIZE];
+  size_t len;
+} out_string_buffer_type;
+
+
+static inline void _out_string_flush(out_string_buffer_type* out)
+{
+  if (out->len) {
+    _putstring(out->data, out->len);
+    out->len = 0U;
+  }
+}
+
+
+// internal buffered _putstring wrapper
+static inline void _out_string(char character, void* buffer, size_t idx, size_t maxlen)
+{
+  (void)idx; (void)maxlen;
+  out_string_buffer_type* out = (out_string_buffer_type*)buffer;
+  if (character) {
+    out->data[out->len++] = character;
+    if (out->len == PRINTF_OUT_BUFFER_SIZE) {
+      _out_string_flush(out);
+    }
+  }
+}
+
+
 // internal output function wrapper
 static inline void _out_fct(char character, void* buffer, size_t idx, size_t maxlen)
 {
@@ -857,8 +894,9 @@ int printf(const char* format, ...)
 {
   va_list va;
   va_start(va, format);
-  char buffer[1];
-  const int ret = _vsnprintf(_out_char, buffer, (size_t)-1, format, va);
+  out_string_buffer_type out = { .len = 0U };
+  const int ret = _vsnprintf(_out_string, (char*)(uintptr_t)&out, (size_t)-1, format, va);
+  _out_string_flush(&out);
   va_end(va);
   return ret;
 }
@@ -886,8 +924,10 @@ int snprintf(char* buffer, size_t count, const char* format, ...)
 
 int vprintf(const char* format, va_list va)
 {
-  char buffer[1];
-  return _vsnprintf(_out_char, buffer, (size_t)-1, format, va);
+  out_string_buffer_type out = { .len = 0U };
+  const int ret = _vsnprintf(_out_string, (char*)(uintptr_t)&out, (size_t)-1, format, va);
+  _out_string_flush(&out);
+  return ret;
 }
 
 
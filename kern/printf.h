@@ -41,6 +41,7 @@
 #include "stdlib.h"
 
 #define _putchar putc
+#define _putstring putsn
 
 
 #ifdef __cplusplus
@@ -56,6 +57,15 @@ extern "C" {
 void _putchar(char character);
 
 
+/**
+ * Output a string of a given length, used by the printf() function to write
+ * what it has formatted in chunks rather than a character at a time
+ * \param str String to output, not necessarily null terminated
+ * \param len Number of characters to output
+ */
+void _putstring(const char* str, size_t len);
+
+
 /**
  * Tiny printf implementation
  * You have to implement _putchar if you use printf()
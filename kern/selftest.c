@@ -4,6 +4,12 @@
 #include "stdlib.h"
 #include "alloc.h"
 #include "htbl.h"
+#include "imap.h"
+#include "intern.h"
+#include "sys/simd.h"
+#include "bench.h"
+#include "cmd.h"
+#include "cksum.h"
 
 #define TEST_LOG(msg) debug(msg); printf("%s\n", msg);
 #define TEST_LOGF(msg, ...) debugf(msg, __VA_ARGS__); printf(msg "\n", __VA_ARGS__);
@@ -72,6 +78,243 @@ cleanup:
     kfree(buf);
 }
 
+void test_memset_pattern()
+{
+    uint16_t* buf = kalloc(2048);
+    buf[1000] = 0x1234; // canary
+
+    // start off a long boundary, with an odd count, to exercise both ends
+    memset16(buf + 1, 0xabcd, 997);
+    for (int i = 1; i < 998; i++) {
+        if (buf[i] != 0xabcd) {
+            TEST_FAIL("memset16", "incorrect value");
+            goto cleanup;
+        }
+    }
+
+    memset32(buf, 0xdeadbeef, 500);
+    for (int i = 0; i < 500; i++) {
+        if (((uint32_t*)buf)[i] != 0xdeadbeef) {
+            TEST_FAIL("memset32", "incorrect value");
+            goto cleanup;
+        }
+    }
+
+    if (buf[1000] != 0x1234) {
+        TEST_FAIL("memset16/32", "canary overwritten");
+    } else {
+        TEST_PASS("memset16/32");
+    }
+
+cleanup:
+    kfree(buf);
+}
+
+// every variant has to cope with short copies and fills at any alignment, not
+// just the large aligned ones it is meant for. in particular, the non-temporal
+// ones copy up to a cache line boundary first, which may be past the end
+void test_memops_impls()
+{
+    static const size_t offsets[] = {0, 3, 13, 61};
+    static const size_t lengths[] = {0, 1, 16, 63, 64, 65, 130};
+    const struct memops_impl* impls;
+    int num_impls = memops_get_impls(&impls);
+
+    // cache line aligned, so the offsets above are relative to a line
+    uint8_t* buf = kalloc_aligned(256, 64);
+    uint8_t* src = kalloc(256);
+    for (int i = 0; i < 256; i++)
+        src[i] = i;
+
+    for (int i = 0; i < num_impls; i++) {
+        for (size_t o = 0; o < sizeof(offsets) / sizeof(*offsets); o++) {
+            for (size_t l = 0; l < sizeof(lengths) / sizeof(*lengths); l++) {
+                size_t off = offsets[o], len = lengths[l];
+
+                memset(buf, 0xee, 256);
+                impls[i].copy(buf + off, src, len);
+                for (size_t j = 0; j < 256; j++) {
+                    int inside = j >= off && j < off + len;
+                    if (buf[j] != (inside ? src[j - off] : 0xee)) {
+                        debugf("%s copy of %d bytes at offset %d", impls[i].name, len, off);
+                        TEST_FAIL("memops variants", "copy wrong or out of bounds");
+                        goto cleanup;
+                    }
+                }
+
+                if (!impls[i].fill)
+                    continue;
+
+                memset(buf, 0xee, 256);
+                impls[i].fill(buf + off, 0x5a, len);
+                for (size_t j = 0; j < 256; j++) {
+                    int inside = j >= off && j < off + len;
+                    if (buf[j] != (inside ? 0x5a : 0xee)) {
+                        debugf("%s fill of %d bytes at offset %d", impls[i].name, len, off);
+                        TEST_FAIL("memops variants", "fill wrong or out of bounds");
+                        goto cleanup;
+                    }
+                }
+            }
+        }
+    }
+
+    TEST_PASS("memops variants");
+
+cleanup:
+    kfree(buf);
+    kfree(src);
+}
+
+void test_memmove()
+{
+    uint8_t* buf = kalloc(1024);
+
+    // move forwards (down) over an overlapping region
+    for (int i = 0; i < 1024; i++)
+        buf[i] = i & 0xff;
+    memmove(buf, buf + 3, 1000);
+    for (int i = 0; i < 1000; i++) {
+        if (buf[i] != ((i + 3) & 0xff)) {
+            TEST_FAIL("memmove", "incorrect value moving down");
+            goto cleanup;
+        }
+    }
+
+    // and backwards (up), which can't be done front to back
+    for (int i = 0; i < 1024; i++)
+        buf[i] = i & 0xff;
+    memmove(buf + 7, buf, 1001);
+    for (int i = 0; i < 1001; i++) {
+        if (buf[i + 7] != (i & 0xff)) {
+            TEST_FAIL("memmove", "incorrect value moving up");
+            goto cleanup;
+        }
+    }
+
+    if (buf[1008] != (1008 & 0xff)) {
+        TEST_FAIL("memmove", "moved past the end");
+    } else {
+        TEST_PASS("memmove");
+    }
+
+cleanup:
+    kfree(buf);
+}
+
+// Byte at a time versions of the string routines, to check the word at a time
+// ones in stdlib against
+static size_t strlen_bytes(const char* s)
+{
+    size_t len = 0;
+    while (*s++) len++;
+    return len;
+}
+
+static int strcmp_bytes(const char* a, const char* b)
+{
+    while (*a && (*a == *b)) {
+        a++; b++;
+    }
+    return *(const unsigned char*)a - *(const unsigned char*)b;
+}
+
+static int stricmp_bytes(const char* a, const char* b)
+{
+    while (*a && (tolower((unsigned char)*a) == tolower((unsigned char)*b))) {
+        a++; b++;
+    }
+    return (unsigned char)*a - (unsigned char)*b;
+}
+
+static int strncmp_bytes(const char* a, const char* b, size_t n)
+{
+    while (n && *a && (*a == *b)) {
+        a++; b++; n--;
+    }
+    return n ? *(const unsigned char*)a - *(const unsigned char*)b : 0;
+}
+
+static char* strchr_bytes(const char* s, int c)
+{
+    do {
+        if (*s == (char)c)
+            return (char*)s;
+    } while (*s++);
+    return NULL;
+}
+
+// time a word at a time string routine against its byte at a time version
+#define STRING_BENCH(name, words, bytes) \
+    do { \
+        uint64_t start = rdtsc(); \
+        for (int i = 0; i < 1000; i++) \
+            bytes; \
+        uint32_t byte_cycles = bench_div64(rdtsc() - start, 1000); \
+        start = rdtsc(); \
+        for (int i = 0; i < 1000; i++) \
+            words; \
+        uint32_t word_cycles = bench_div64(rdtsc() - start, 1000); \
+        TEST_LOGF("       %-8s %5d %5d", name, byte_cycles, word_cycles); \
+    } while (0)
+
+void test_strings()
+{
+    static const char alphabet[] = "aAbBzZ@[`{09 \x80\xc1";
+    char* a = kalloc(64);
+    char* b = kalloc(64);
+
+    // every combination of alignment and a range of lengths, with the strings
+    // equal, differing only in case, or differing in their last character
+    for (int align = 0; align < 16; align++) {
+        for (int len = 0; len < 40; len++) {
+            for (int variant = 0; variant < 3; variant++) {
+                char* sa = a + (align & 3);
+                char* sb = b + (align >> 2);
+                for (int i = 0; i < len; i++)
+                    sa[i] = sb[i] = alphabet[(i * 7 + len) % (sizeof(alphabet) - 1)];
+                sa[len] = sb[len] = '\0';
+
+                if (len && variant == 1)
+                    sb[len - 1] ^= 0x20;
+                else if (len && variant == 2)
+                    sb[len - 1] = '#';
+
+                int c = alphabet[len % (sizeof(alphabet) - 1)];
+                if (strlen(sa) != strlen_bytes(sa)
+                        || strcmp(sa, sb) != strcmp_bytes(sa, sb)
+                        || stricmp(sa, sb) != stricmp_bytes(sa, sb)
+                        || strncmp(sa, sb, len / 2 + variant) != strncmp_bytes(sa, sb, len / 2 + variant)
+                        || strchr(sa, c) != strchr_bytes(sa, c)
+                        || strchr(sa, '\0') != strchr_bytes(sa, '\0')) {
+                    TEST_FAIL("strings", "differs from byte at a time result");
+                    goto cleanup;
+                }
+            }
+        }
+    }
+
+    TEST_PASS("strings");
+
+    if (!bench_available())
+        goto cleanup;
+
+    // how much quicker the word at a time versions are, on a typical length
+    // of key in one of the hash tables
+    const char* key = "module.symbol_name.32";
+    const char* other = "MODULE.symbol_name.33";
+    TEST_LOG("       cycles per call, byte at a time vs word at a time:");
+    STRING_BENCH("strlen", strlen(key), strlen_bytes(key));
+    STRING_BENCH("strcmp", strcmp(key, key), strcmp_bytes(key, key));
+    STRING_BENCH("stricmp", stricmp(key, other), stricmp_bytes(key, other));
+    STRING_BENCH("strncmp", strncmp(key, other + 6, 14), strncmp_bytes(key, other + 6, 14));
+    STRING_BENCH("strchr", strchr(key, '3'), strchr_bytes(key, '3'));
+
+cleanup:
+    kfree(a);
+    kfree(b);
+}
+
 void test_kallocz()
 {
     uint8_t* buf = kallocz(1024);
@@ -158,12 +401,209 @@ cleanup:
     htbl_destroy(table);
 }
 
+void test_htbl_remove()
+{
+    htbl_t* table = htbl_create();
+
+    // enough keys that removing some has to shift others back into place
+    for (int i = 0; i < 100; i++) {
+        char buf[64];
+        sprintf(buf, "key_%d", i);
+        htbl_put(table, buf, (void*)(i + 1));
+    }
+
+    for (int i = 0; i < 100; i += 2) {
+        char buf[64];
+        sprintf(buf, "key_%d", i);
+        if (htbl_remove(table, buf) != (void*)(i + 1)) {
+            TEST_FAIL("htbl_remove", "returned wrong value for key");
+            goto cleanup;
+        }
+    }
+
+    for (int i = 0; i < 100; i++) {
+        char buf[64];
+        sprintf(buf, "key_%d", i);
+        void* expect = (i % 2) ? (void*)(i + 1) : NULL;
+        if (htbl_get(table, buf) != expect) {
+            TEST_FAIL("htbl_remove", "lookup wrong after removal");
+            goto cleanup;
+        }
+    }
+
+    if (htbl_length(table) != 50 || htbl_remove(table, "key_0") != NULL) {
+        TEST_FAIL("htbl_remove", "wrong length or removed missing key");
+        goto cleanup;
+    }
+
+    TEST_PASS("htbl_remove");
+
+cleanup:
+    htbl_destroy(table);
+}
+
+void test_imap()
+{
+    imap_t* map = imap_create();
+
+    // enough keys that the map has to expand, including zero
+    for (int i = 0; i < 100; i++)
+        imap_put(map, i * 4, (void*)(i + 1));
+
+    for (int i = 0; i < 100; i += 2)
+        imap_remove(map, i * 4);
+
+    for (int i = 0; i < 100; i++) {
+        void* expect = (i % 2) ? (void*)(i + 1) : NULL;
+        if (imap_get(map, i * 4) != expect) {
+            TEST_FAIL("imap", "key mapped to incorrect value");
+            goto cleanup;
+        }
+    }
+
+    if (imap_length(map) != 50) {
+        TEST_FAIL("imap", "wrong length after removal");
+        goto cleanup;
+    }
+
+    TEST_PASS("imap");
+
+cleanup:
+    imap_destroy(map);
+}
+
+void test_intern()
+{
+    char name[] = "selftest:intern";
+    const char* interned = intern(name);
+
+    if (interned == name || intern(name) != interned || intern_lookup(name) != interned) {
+        TEST_FAIL("intern", "equal strings interned differently");
+        return;
+    }
+
+    if (intern_lookup("selftest:never_interned") != NULL) {
+        TEST_FAIL("intern", "found string which was never interned");
+        return;
+    }
+
+    TEST_PASS("intern");
+}
+
+void test_simd_nesting()
+{
+    if (!kernel_simd_begin()) {
+        TEST_PASS("simd_nesting (SIMD disabled)");
+        return;
+    }
+
+    uint32_t outer[4] = { 0x11111111, 0x22222222, 0x33333333, 0x44444444 };
+    uint32_t inner[4] = { 0 };
+    uint32_t result[4];
+
+    asm volatile("movdqu %0, %%xmm0" : : "m" (outer));
+
+    // an inner region may clobber the registers, but they must be restored
+    // for the outer one when it ends
+    if (kernel_simd_begin()) {
+        asm volatile("movdqu %0, %%xmm0" : : "m" (inner));
+        kernel_simd_end();
+    }
+
+    asm volatile("movdqu %%xmm0, %0" : "=m" (result));
+    kernel_simd_end();
+
+    if (memcmp(result, outer, sizeof(outer)) != 0) {
+        TEST_FAIL("simd_nesting", "outer region's registers not restored");
+    } else {
+        TEST_PASS("simd_nesting");
+    }
+}
+
+void test_cmd_split()
+{
+    // enough words that the argument array has to grow, with runs of spaces
+    char line[] = "  cmd a  bb ccc d e f g h i   j ";
+    const char* expected[] = { "cmd", "a", "bb", "ccc", "d", "e", "f", "g", "h", "i", "j" };
+    int count = sizeof(expected) / sizeof(expected[0]);
+
+    ARENA_ON_STACK(scratch, 32);
+    char** argv;
+    int argc = cmd_split(line, &scratch, &argv);
+
+    if (argc != count) {
+        TEST_FAIL("cmd_split", "wrong number of words");
+        goto cleanup;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (strcmp(argv[i], expected[i]) != 0) {
+            TEST_FAIL("cmd_split", "word split incorrectly");
+            goto cleanup;
+        }
+    }
+
+    if (argv[argc] != NULL) {
+        TEST_FAIL("cmd_split", "argv not NULL terminated");
+        goto cleanup;
+    }
+
+    TEST_PASS("cmd_split");
+
+cleanup:
+    arena_destroy(&scratch);
+}
+
+void test_cksum()
+{
+    const char* check = "123456789";
+
+    if (crc32(CRC32_INIT, check, 9) != 0xcbf43926) {
+        TEST_FAIL("cksum", "crc32 check value wrong");
+        return;
+    }
+
+    // split unevenly, so the slicing and the unaligned head both get used
+    uint32_t crc = crc32(CRC32_INIT, check, 1);
+    if (crc32(crc, check + 1, 8) != 0xcbf43926) {
+        TEST_FAIL("cksum", "crc32 wrong when calculated in pieces");
+        return;
+    }
+
+    if (adler32(ADLER32_INIT, "Wikipedia", 9) != 0x11e60398) {
+        TEST_FAIL("cksum", "adler32 check value wrong");
+        return;
+    }
+
+    // an IPv4 header, with the checksum field zeroed
+    const uint8_t ip_header[20] = {
+        0x45, 0x00, 0x00, 0x73, 0x00, 0x00, 0x40, 0x00, 0x40, 0x11,
+        0x00, 0x00, 0xc0, 0xa8, 0x00, 0x01, 0xc0, 0xa8, 0x00, 0xc7
+    };
+    if (cksum_inet(ip_header, sizeof(ip_header)) != 0xb861) {
+        TEST_FAIL("cksum", "internet checksum wrong");
+        return;
+    }
+
+    TEST_PASS("cksum");
+}
+
 void selftest(int argc, char** argv)
 {
     test_memcpy();
     test_memset();
+    test_memset_pattern();
+    test_memops_impls();
+    test_memmove();
+    test_strings();
     test_kallocz();
     test_htbl();
     test_htbl_expand();
+    test_htbl_remove();
+    test_imap();
+    test_intern();
+    test_simd_nesting();
+    test_cmd_split();
+    test_cksum();
 }
 
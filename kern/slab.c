@@ -0,0 +1,267 @@
+/**
+ * @file slab.c
+ * @brief Slab caches for fixed-size objects
+ *
+ * A cache hands out objects of a single size from slabs: SLAB_SIZE byte,
+ * SLAB_SIZE aligned chunks of heap memory which are divided into as many
+ * objects as will fit. Allocating and freeing an object is just popping and
+ * pushing a slab's free list, and none of the objects carry a heap block
+ * header, so small objects which come and go often (list nodes, handles and
+ * the like) are both faster and cheaper than going through kalloc directly.
+ */
+
+#include "slab.h"
+#include "alloc.h"
+#include "stdlib.h"
+#include <export.h>
+
+// every cache which has created a slab
+static slab_cache_t* caches = NULL;
+
+static size_t slab_aligned(size_t size)
+{
+    return (size + SLAB_ALIGNMENT - 1) & ~(size_t)(SLAB_ALIGNMENT - 1);
+}
+
+static struct slab* slab_of(void* obj)
+{
+    return (struct slab*)((uintptr_t)obj & ~(uintptr_t)(SLAB_SIZE - 1));
+}
+
+static void slab_list_push(struct slab** list, struct slab* slab)
+{
+    slab->prev = NULL;
+    slab->next = *list;
+    if (*list)
+        (*list)->prev = slab;
+    *list = slab;
+}
+
+static void slab_list_remove(struct slab** list, struct slab* slab)
+{
+    if (slab->prev)
+        slab->prev->next = slab->next;
+    else
+        *list = slab->next;
+
+    if (slab->next)
+        slab->next->prev = slab->prev;
+}
+
+// allocate a new slab for the cache, with all of its objects free
+static struct slab* slab_new(slab_cache_t* cache)
+{
+    if (!cache->objs_per_slab) {
+        cache->stride = slab_aligned(MAX(cache->obj_size, sizeof(void*)));
+        cache->objs_per_slab = (SLAB_SIZE - slab_aligned(sizeof(struct slab))) / cache->stride;
+        ASSERT(cache->objs_per_slab, "Object too large for a slab");
+    }
+
+    if (!cache->registered) {
+        cache->next_cache = caches;
+        caches = cache;
+        cache->registered = 1;
+    }
+
+    struct slab* slab = kalloc_aligned(SLAB_SIZE, SLAB_SIZE);
+    slab->magic = SLAB_MAGIC;
+    slab->cache = cache;
+    slab->in_use = 0;
+    slab->free = NULL;
+
+    // thread the free list backwards, so objects are handed out in order
+    uint8_t* objs = (uint8_t*)slab + slab_aligned(sizeof(struct slab));
+    for (size_t i = cache->objs_per_slab; i > 0; i--) {
+        void* obj = objs + (i - 1) * cache->stride;
+        *(void**)obj = slab->free;
+        slab->free = obj;
+    }
+
+    cache->num_slabs++;
+    return slab;
+}
+
+static void slab_release(slab_cache_t* cache, struct slab* slab)
+{
+    slab->magic = 0;
+    kfree(slab);
+    cache->num_slabs--;
+}
+
+/**
+ * @brief Initialise a cache for objects of a given size. Equivalent to
+ * SLAB_CACHE_INIT for caches which can't be statically initialised.
+ *
+ * @param cache the cache to initialise
+ * @param name the name of the cache, which must outlive it
+ * @param obj_size the size of each object, in bytes
+ */
+void slab_cache_init(slab_cache_t* cache, const char* name, size_t obj_size)
+{
+    ASSERT(cache, "NULL cache");
+    memset(cache, 0, sizeof(*cache));
+    cache->name = name;
+    cache->obj_size = obj_size;
+}
+EXPORT_SYM(slab_cache_init);
+
+/**
+ * @brief Create a cache for objects of a given size, with the cache itself
+ * allocated from the heap.
+ *
+ * @param name the name of the cache, which must outlive it
+ * @param obj_size the size of each object, in bytes
+ * @return slab_cache_t* the new cache, which should be destroyed with
+ * `slab_cache_destroy`
+ */
+slab_cache_t* slab_cache_create(const char* name, size_t obj_size)
+{
+    slab_cache_t* cache = kalloc(sizeof(*cache));
+    slab_cache_init(cache, name, obj_size);
+    cache->owned = 1;
+    return cache;
+}
+EXPORT_SYM(slab_cache_create);
+
+/**
+ * @brief Destroy a cache, giving all of its slabs back to the heap. Every
+ * object allocated from the cache must already have been freed.
+ *
+ * @param cache the cache to destroy
+ */
+void slab_cache_destroy(slab_cache_t* cache)
+{
+    ASSERT(cache->in_use == 0, "Destroyed cache with objects still in use");
+    ASSERT(!cache->full, "Cache has full slabs but no objects in use");
+
+    slab_cache_shrink(cache);
+    while (cache->partial) {
+        struct slab* slab = cache->partial;
+        slab_list_remove(&cache->partial, slab);
+        slab_release(cache, slab);
+    }
+
+    for (slab_cache_t** current = &caches; *current; current = &(*current)->next_cache) {
+        if (*current == cache) {
+            *current = cache->next_cache;
+            break;
+        }
+    }
+
+    if (cache->owned)
+        kfree(cache);
+}
+EXPORT_SYM(slab_cache_destroy);
+
+/**
+ * @brief Allocate an object from a cache.
+ *
+ * @param cache the cache to allocate from
+ * @return void* the object, of at least the cache's object size
+ */
+void* slab_alloc(slab_cache_t* cache)
+{
+    struct slab* slab = cache->partial;
+    if (!slab) {
+        if (cache->empty) {
+            slab = cache->empty;
+            cache->empty = NULL;
+        } else {
+            slab = slab_new(cache);
+        }
+        slab_list_push(&cache->partial, slab);
+    }
+
+    void* obj = slab->free;
+    slab->free = *(void**)obj;
+    slab->in_use++;
+
+    if (!slab->free) {
+        slab_list_remove(&cache->partial, slab);
+        slab_list_push(&cache->full, slab);
+    }
+
+    cache->in_use++;
+    cache->total_allocs++;
+    if (cache->in_use > cache->peak_in_use)
+        cache->peak_in_use = cache->in_use;
+
+    return obj;
+}
+EXPORT_SYM(slab_alloc);
+
+/**
+ * @brief Allocate an object from a cache and clear it.
+ *
+ * @param cache the cache to allocate from
+ * @return void* the object, of at least the cache's object size
+ */
+void* slab_allocz(slab_cache_t* cache)
+{
+    void* obj = slab_alloc(cache);
+    memset(obj, 0, cache->obj_size);
+    return obj;
+}
+EXPORT_SYM(slab_allocz);
+
+/**
+ * @brief Free an object, returning it to the cache it was allocated from.
+ *
+ * @param cache the cache the object was allocated from
+ * @param obj the object to free
+ */
+void slab_free(slab_cache_t* cache, void* obj)
+{
+    struct slab* slab = slab_of(obj);
+    ASSERT(slab->magic == SLAB_MAGIC, "Tried to free object not allocated from a slab");
+    ASSERT(slab->cache == cache, "Tried to free object to the wrong cache");
+    ASSERT(slab->in_use, "Tried to free object in empty slab");
+
+    if (!slab->free) {
+        slab_list_remove(&cache->full, slab);
+        slab_list_push(&cache->partial, slab);
+    }
+
+    *(void**)obj = slab->free;
+    slab->free = obj;
+    slab->in_use--;
+
+    cache->in_use--;
+    cache->total_frees++;
+
+    if (!slab->in_use) {
+        slab_list_remove(&cache->partial, slab);
+        if (cache->empty)
+            slab_release(cache, slab);
+        else
+            cache->empty = slab;
+    }
+}
+EXPORT_SYM(slab_free);
+
+/**
+ * @brief Give any slab a cache is holding on to with no objects allocated back
+ * to the heap.
+ *
+ * @param cache the cache to shrink
+ */
+void slab_cache_shrink(slab_cache_t* cache)
+{
+    if (cache->empty) {
+        slab_release(cache, cache->empty);
+        cache->empty = NULL;
+    }
+}
+EXPORT_SYM(slab_cache_shrink);
+
+/**
+ * @brief Iterate over every cache which has allocated memory.
+ *
+ * @param fn function pointer to be invoked for each cache
+ */
+void slab_foreach(void (*fn)(slab_cache_t*))
+{
+    for (slab_cache_t* current = caches; current; current = current->next_cache)
+        fn(current);
+}
+EXPORT_SYM(slab_foreach);
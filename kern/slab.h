@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Size of each slab. Slabs are also aligned to this, so the slab an object
+// belongs to can be found by rounding the object's address down
+#define SLAB_SIZE           4096
+// Alignment of every object allocated from a slab
+#define SLAB_ALIGNMENT      8
+#define SLAB_MAGIC          0x51ab51ab
+
+typedef struct slab_cache slab_cache_t;
+
+// Header at the start of every slab, the objects follow it
+struct slab {
+    uint32_t magic;
+    slab_cache_t* cache;
+    // neighbouring slabs in whichever of the cache's lists this slab is in
+    struct slab* next;
+    struct slab* prev;
+    // free objects in this slab, linked through their first word
+    void* free;
+    // the number of objects in this slab currently allocated
+    size_t in_use;
+};
+
+typedef struct slab_cache {
+    const char* name;
+    size_t obj_size;
+    // the distance between objects in a slab, and how many fit in each slab.
+    // worked out when the first slab is created
+    size_t stride;
+    size_t objs_per_slab;
+    // slabs with at least one free object, and slabs with none
+    struct slab* partial;
+    struct slab* full;
+    // a single slab with no objects allocated, kept around so that an object
+    // being repeatedly allocated and freed doesn't churn the heap
+    struct slab* empty;
+    // statistics
+    size_t num_slabs;
+    size_t in_use;
+    size_t peak_in_use;
+    size_t total_allocs;
+    size_t total_frees;
+    // every cache which has created a slab, see slab_foreach
+    struct slab_cache* next_cache;
+    int registered;
+    // non-zero if the cache itself was allocated by `slab_cache_create`
+    int owned;
+} slab_cache_t;
+
+// Statically initialise a cache named `cache_name` for objects of `size`
+// bytes. No further initialisation is needed before it can be used.
+#define SLAB_CACHE_INIT(cache_name, size) { .name = (cache_name), .obj_size = (size) }
+
+void slab_cache_init(slab_cache_t* cache, const char* name, size_t obj_size);
+slab_cache_t* slab_cache_create(const char* name, size_t obj_size);
+void slab_cache_destroy(slab_cache_t* cache);
+void* slab_alloc(slab_cache_t* cache);
+void* slab_allocz(slab_cache_t* cache);
+void slab_free(slab_cache_t* cache, void* obj);
+void slab_cache_shrink(slab_cache_t* cache);
+void slab_foreach(void (*fn)(slab_cache_t*));
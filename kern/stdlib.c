@@ -3,342 +3,44 @@
 #include "io/vga.h"
 #include "io/serial.h"
 #include "io/keyboard.h"
+#include "io/driver.h"
 #include "kernel.h"
 #include "alloc.h"
 #include "backtrace.h"
+#include "sys/cpuid.h"
+#include "sys/simd.h"
+#include "swar.h"
 
 static int should_echo = 1;
 static enum log_level log_level = DEBUG_LEVEL;
 
-void swap(char* x, char* y)
-{
-    char temp = *x;
-    *x = *y;
-    *y = temp;
-}
-
-void reverse(char* buffer, int i, int j)
-{
-    while (i < j)
-        swap(&buffer[i++], &buffer[j--]);
-}
-
-/**
- * @brief Convert an integer to an ascii value
- *
- * @param value the integer value
- * @param buffer the buffer to place the result in
- * @param base the base to output the number in
- */
-void itoa(int value, char* buffer, int base)
-{
-    if (base < 2 || base > 32)
-        return;
-
-    int n = value < 0 ? -value : value;
-
-    int i = 0;
-    while (n) {
-        int rem = n % base;
-        if (rem >= 10)
-            buffer[i++] = 'A' + (rem - 10);
-        else
-            buffer[i++] = '0' + rem;
-        n /= base;
-    }
-
-    if (i == 0)
-        buffer[i++] = '0';
-
-    if (value < 0 && base == 10)
-        buffer[i++] = '-';
-
-    buffer[i] = '\0';
-
-    reverse(buffer, 0, i - 1);
-}
-
-/**
- * @brief Convert an ASCII string which is a base 10 number into its integer
- * representation. If the string contains non-digit characters, the behaviour
- * is undefined.
- *
- * @param str the string to convert
- * @return int the integer result
- */
-int atoi(const char* str)
-{
-    int n = 0;
-    int neg_flag = 0;
-
-    switch (*str) {
-        case '-': neg_flag = 1;
-        case '+': str++;
-    }
-
-    while (*str != '\0')
-        n = 10 * n - (*str++ - '0');
-
-    return neg_flag ? n : -n;
-}
-
-/**
- * @brief Determine if a character is a space.
- *
- * @param c the character to check
- * @return int non-zero if the character is a space
- */
-int isspace(int c)
-{
-    return (c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
-        c == '\r' || c == ' ') ? 1 : 0;
-}
-
-/**
- * @brief Determine if a character is a blank.
- *
- * @param c the character to check
- * @return int non-zero if the character is a space or tab
- */
-int isblank(int c)
-{
-    return (c == '\t' || c == ' ') ? 1 : 0;
-}
-
-/**
- * @brief Determine if a character is a digit, 0 through 9.
- *
- * @param c the character to check
- * @return int non-zero if the character is a digit
- */
-int isdigit(int c)
-{
-    return (c >= '0' && c <= '9') ? 1 : 0;
-}
-
-/**
- * @brief Determine if a character is an alphabetic character, either
- * lower or upper case.
- *
- * @param c the character to check
- * @return int non-zero if the character is an alphabetic character
- */
-int isalpha(int c)
-{
-    return ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) ? 1 : 0;
-}
-
-/**
- * @brief Determine if a character is upper case.
- *
- * @param c the character to check
- * @return int non-zero if the character is upper case
- */
-int isupper(int c)
-{
-    return (c >= 'A' && c <= 'Z') ? 1 : 0;
-}
-
-/**
- * @brief Determine if a character is lower case.
- *
- * @param c the character to check
- * @return int non-zero if the character is lower case
- */
-int islower(int c)
-{
-    return (c > 'a' && c < 'z') ? 1 : 0;
-}
-
-/**
- * @brief Convert the first numeric part of the string nptr to the given
- * base, or try to determine the base.
- *
- * @param nptr the string which contains the numeric to convert
- * @param endptr if non-NULL then a pointer to the character following the
- *               last character of the number
- * @param base the base of the number to convert, between 2 to 36 specifies
- *             explicitly the base to convert to. 0 indicates the base is
- *             detected from the given string
- * @return unsigned long the converted value
- */
-unsigned long strtoul(const char* nptr, char** endptr, int base)
-{
-    int neg = 0;
-
-    // skip whitespace
-    const char* p = nptr;
-    while (isspace(*p)) {
-        p++;
-    }
-
-    // do we have a sign?
-    if (*p == '-') {
-        neg = 1;
-        p++;
-    } else if (*p == '+') {
-        p++;
-    }
-
-    // is this hex?
-    char next = *(p + 1);
-    if ((base == 0 || base == 16) && *p == '0' && (next == 'x'  || next == 'X')) {
-        p += 2;
-        base = 16;
-    }
-    // octal or decimal
-    if (base == 0) {
-        base = *p == '0' ? 8 : 10;
-    }
-
-    unsigned long acc = 0;
-    unsigned long cutoff = 0xfffffffful / (unsigned long)base;
-    unsigned long cutlim = 0xfffffffful % (unsigned long)base;
-    int any = 0;
-    for (;; p++) {
-        int c = *p;
-        if (isdigit(c)) {
-            c -= '0';
-        } else if (isalpha(c)) {
-            c -= isupper(c) ? 'A' - 10 : 'a' - 10;
-        } else {
-            break;
-        }
-
-        if (c >= base) {
-            break;
-        }
-        if (any < 0 || acc > cutoff || (acc == cutoff && c > cutlim)) {
-            any = -1;
-        } else {
-            any = 1;
-            acc *= base;
-            acc += c;
-        }
-    }
-    if (any < 0) {
-        acc = 0xfffffffful;
-    } else if (neg) {
-        acc = -acc;
-    }
-    if (endptr != 0) {
-        *endptr = (char*)(any ? p - 1 : nptr);
-    }
-    return acc;
-}
-
 /**
- * @brief Tokenise a string reentrantly
- *
- * @param str pointer to the string, may be null on subsequent calls
- * @param delim a string containing all possible delimiters
- * @param saveptr used to save the internal state of the strtok_r function across
- *                multiple calls
- * @return char* the pointer to the next token
- */
-// Based on the PDCLib version of strtok
-char* strtok_r(char* str, const char* delim, char** saveptr)
-{
-    if (str != NULL) {
-        // new string
-        *saveptr = str;
-    } else {
-        if (*saveptr == NULL) {
-            // stuck! no new string, nor any old string
-            return NULL;
-        }
-        str = *saveptr;
-    }
-
-    const char* p = delim;
-    while (*p && *str) {
-        if (*str == *p) {
-            // found delim
-            str++;
-            p = delim;
-            continue;
-        }
-
-        p++;
-    }
-
-    if (!*str) {
-        // nothing left
-        *saveptr = str;
-        return NULL;
-    }
-
-    // skip non-delim chrs
-    *saveptr = str;
-
-    while (**saveptr) {
-        p = delim;
-        while (*p) {
-            if (**saveptr == *p++) {
-                // found delim
-                *((*saveptr)++) = '\0';
-                return str;
-            }
-        }
-
-        (*saveptr)++;
-    }
-
-    return str;
-}
-
-/**
- * @brief Tokenise a string
- *
- * @param str pointer to the string, may be null on subsequent calls
- * @param delim a string containing all possible delimiters
- * @return char* the pointer to the next token
- */
-char* strtok(char* str, const char* delim)
-{
-    static char* saveptr;
-    return strtok_r(str, delim, &saveptr);
-}
-
-/**
- * @brief Determine the length of a given string
- *
- * @param str the string
- * @return size_t the length of the string
- */
-size_t strlen(const char* str)
-{
-    size_t len = 0;
-    while (*str++) len++;
-    return len;
-}
-
-/**
- * @brief Concatenate two strings together
+ * @brief Print a string
  *
- * @param dst the destination
- * @param src the source
+ * @param str the string to print
  */
-void strcat(char* dst, const char* src)
+void puts(const char* str)
 {
-    while (*dst)
-        dst++;
-
-    // Note: assignment _not_ equals, copies until *src == '\0'
-    while ((*dst++ = *src++));
+    putsn(str, strlen(str));
 }
+EXPORT_SYM(puts);
 
 /**
- * @brief Print a string
+ * @brief Print a string of a given length, which doesn't need to be null
+ * terminated. This goes to stdout in a single write where it supports it, so is
+ * much faster than printing each character in turn.
  *
  * @param str the string to print
+ * @param len the number of characters to print
  */
-void puts(const char* str)
+void putsn(const char* str, size_t len)
 {
-    while (*str)
-        putc(*str++);
+    if (!stdout || !len)
+        return;
+
+    chardev_write_buf(stdout, str, len);
 }
-EXPORT_SYM(puts);
+EXPORT_SYM(putsn);
 EXPORT_SYM(printf);
 
 /**
@@ -423,145 +125,352 @@ void gets(char* str)
 }
 EXPORT_SYM(gets);
 
+/*
+ * The memory operations come in a few variants, and the best ones the CPU
+ * supports are picked by memops_init(). Until then the plain 386 variants are
+ * used, so memcpy and memset are safe to call from the very start of boot.
+ */
+
+// copies and fills smaller than this aren't worth anything fancier than
+// rep movsl/stosl
+#define MEMOPS_SMALL            64
+// copies and fills at least this large bypass the cache, as they would only
+// evict everything useful from it and never be read back in time to benefit
+#define MEMOPS_NT_THRESHOLD     (256 * 1024)
+
+static void memcpy_movsl(void* dst, const void* src, size_t len);
+static void fill_stosl(void* memory, uint32_t pattern, size_t len);
+static void memset_stosl(void* memory, uint8_t value, size_t len);
+
+static void (*memcpy_bulk)(void*, const void*, size_t) = memcpy_movsl;
+static void (*memcpy_nt)(void*, const void*, size_t) = memcpy_movsl;
+static void (*memset_bulk)(void*, uint8_t, size_t) = memset_stosl;
+static void (*fill_nt)(void*, uint32_t, size_t) = fill_stosl;
+static size_t memops_nt_threshold = ~(size_t)0;
+static const char* memops_variant = "movsl";
+
+// every variant this CPU supports, so they can be benchmarked
+static struct memops_impl memops_impls[4] = {
+    { "movsl", memcpy_movsl, memset_stosl },
+};
+static int memops_num_impls = 1;
+
 /**
- * @brief Compare two strings. A non-zero return value indicates that the strings
- * differ in at least one location
- *
- * @param a the first string
- * @param b the second string
- * @return int zero if identical, non-zero otherwise
+ * @brief Copy memory a long at a time, and then the remaining bytes. Works on
+ * every CPU.
  */
-int strcmp(const char* a, const char* b)
+static void memcpy_movsl(void* dst, const void* src, size_t len)
 {
-    while (*a && (*a == *b)) {
-        a++; b++;
-    }
-    return *(const unsigned char*)a - *(const unsigned char*)b;
+    int tmp[3];
+    asm volatile(
+        "rep movsl\n\t"         // move as much as we can long-sized
+        "movl   %6, %%ecx\n\t"  // then the rest byte-sized
+        "andl   $3, %%ecx\n\t"
+        "rep movsb"
+        : "=S" (tmp[0]), "=D" (tmp[1]), "=c" (tmp[2])
+        : "0" (src), "1" (dst), "2" (len / 4), "r" (len)
+        : "memory"
+    );
 }
 
 /**
- * @Brief Compare two strings without regard for the case of the characters. A
- * non-zero return value indicates that the strings differn in at least one
- * location
- *
- * @param a the first string
- * @param b the second string
- * @return int zero if identical (apart from case), non-zero otherwise
+ * @brief Copy memory with a single rep movsb, which CPUs with enhanced
+ * rep movsb/stosb (ERMS) perform in whole cache lines where they can.
  */
-int stricmp(const char* a, const char* b)
+static void memcpy_erms(void* dst, const void* src, size_t len)
 {
-    while (*a && (tolower((unsigned char)*a) == tolower((unsigned char)*b))) {
-        a++; b++;
-    }
-    return (unsigned char)*a - (unsigned char)*b;
+    int tmp[3];
+    asm volatile(
+        "rep movsb"
+        : "=S" (tmp[0]), "=D" (tmp[1]), "=c" (tmp[2])
+        : "0" (src), "1" (dst), "2" (len)
+        : "memory"
+    );
 }
 
 /**
- * @brief Convert a character to lowercase. If the character is not a letter, or
- * is already lowercase, it will be returned as-is
- *
- * @param ch the character to make lowercase
- * @return int the lowercase character
+ * @brief Copy memory 64 bytes at a time through the MMX registers. Unless SIMD
+ * is enabled nothing else in the kernel saves the MMX state, so interrupts are
+ * kept off while the registers are in use.
  */
-int tolower(int ch)
+static void memcpy_mmx(void* dst, const void* src, size_t len)
 {
-    if (ch >= 'A' && ch <= 'Z')
-        return ch ^ 0x20;
-    else
-        return ch;
+    // the MMX registers alias the FPU's, which may belong to a user program
+    int simd = kernel_simd_begin();
+
+    if (len >= 64) {
+        int tmp[3];
+        asm volatile(
+            "pushf\n\t"
+            "cli\n\t"
+            "1:\n\t"
+            "movq  0(%%esi), %%mm0\n\t"
+            "movq  8(%%esi), %%mm1\n\t"
+            "movq 16(%%esi), %%mm2\n\t"
+            "movq 24(%%esi), %%mm3\n\t"
+            "movq 32(%%esi), %%mm4\n\t"
+            "movq 40(%%esi), %%mm5\n\t"
+            "movq 48(%%esi), %%mm6\n\t"
+            "movq 56(%%esi), %%mm7\n\t"
+            "movq %%mm0,  0(%%edi)\n\t"
+            "movq %%mm1,  8(%%edi)\n\t"
+            "movq %%mm2, 16(%%edi)\n\t"
+            "movq %%mm3, 24(%%edi)\n\t"
+            "movq %%mm4, 32(%%edi)\n\t"
+            "movq %%mm5, 40(%%edi)\n\t"
+            "movq %%mm6, 48(%%edi)\n\t"
+            "movq %%mm7, 56(%%edi)\n\t"
+            "add $64, %%esi\n\t"
+            "add $64, %%edi\n\t"
+            "dec %%ecx\n\t"
+            "jnz 1b\n\t"
+            "emms\n\t"
+            "popf"
+            : "=S" (tmp[0]), "=D" (tmp[1]), "=c" (tmp[2])
+            : "0" (src), "1" (dst), "2" (len >> 6)
+            : "memory"
+        );
+    }
+
+    if (simd)
+        kernel_simd_end();
+
+    size_t copied = len & ~0x3f;
+    memcpy_movsl(dst + copied, src + copied, len - copied);
 }
 
 /**
- * @brief Compare two strings for a given number of characters
- *
- * @param a the first string
- * @param b the second string
- * @param n the number of characters to compare
- * @return int zero if identical for all indicated characters, non-zero otherwise
+ * @brief Copy memory with SSE2 non-temporal stores, which go straight to
+ * memory rather than through the cache. movnti works on the general purpose
+ * registers, so there is no SSE state to worry about.
  */
-int strncmp(const char* a, const char* b, size_t n)
+static void memcpy_movnti(void* dst, const void* src, size_t len)
 {
-    while (n && *a && (*a == *b)){
-        ++a;
-        ++b;
-        --n;
-    }
+    // line the destination up so the stores fill whole cache lines. a copy
+    // which doesn't reach the next line is done entirely here
+    size_t head = MIN(-(uintptr_t)dst & 0x3f, len);
+    memcpy_movsl(dst, src, head);
+    dst += head;
+    src += head;
+    len -= head;
 
-    if (n == 0) {
-        return 0;
-    } else {
-        return (*(const unsigned char *)a - *(unsigned char *)b);
+    if (len >= 64) {
+        int tmp[3];
+        asm volatile(
+            "1:\n\t"
+            "prefetchnta 256(%%esi)\n\t"
+            "movl  0(%%esi), %%eax\n\t"
+            "movl  4(%%esi), %%edx\n\t"
+            "movnti %%eax,  0(%%edi)\n\t"
+            "movnti %%edx,  4(%%edi)\n\t"
+            "movl  8(%%esi), %%eax\n\t"
+            "movl 12(%%esi), %%edx\n\t"
+            "movnti %%eax,  8(%%edi)\n\t"
+            "movnti %%edx, 12(%%edi)\n\t"
+            "movl 16(%%esi), %%eax\n\t"
+            "movl 20(%%esi), %%edx\n\t"
+            "movnti %%eax, 16(%%edi)\n\t"
+            "movnti %%edx, 20(%%edi)\n\t"
+            "movl 24(%%esi), %%eax\n\t"
+            "movl 28(%%esi), %%edx\n\t"
+            "movnti %%eax, 24(%%edi)\n\t"
+            "movnti %%edx, 28(%%edi)\n\t"
+            "movl 32(%%esi), %%eax\n\t"
+            "movl 36(%%esi), %%edx\n\t"
+            "movnti %%eax, 32(%%edi)\n\t"
+            "movnti %%edx, 36(%%edi)\n\t"
+            "movl 40(%%esi), %%eax\n\t"
+            "movl 44(%%esi), %%edx\n\t"
+            "movnti %%eax, 40(%%edi)\n\t"
+            "movnti %%edx, 44(%%edi)\n\t"
+            "movl 48(%%esi), %%eax\n\t"
+            "movl 52(%%esi), %%edx\n\t"
+            "movnti %%eax, 48(%%edi)\n\t"
+            "movnti %%edx, 52(%%edi)\n\t"
+            "movl 56(%%esi), %%eax\n\t"
+            "movl 60(%%esi), %%edx\n\t"
+            "movnti %%eax, 56(%%edi)\n\t"
+            "movnti %%edx, 60(%%edi)\n\t"
+            "add $64, %%esi\n\t"
+            "add $64, %%edi\n\t"
+            "dec %%ecx\n\t"
+            "jnz 1b\n\t"
+            "sfence"                // make the stores visible before we return
+            : "=S" (tmp[0]), "=D" (tmp[1]), "=c" (tmp[2])
+            : "0" (src), "1" (dst), "2" (len >> 6)
+            : "eax", "edx", "memory"
+        );
     }
+
+    size_t copied = len & ~0x3f;
+    memcpy_movsl(dst + copied, src + copied, len - copied);
 }
 
 /**
- * @brief Copy a string to the location pointed to by dst
- *
- * @param dst where to copy the string to
- * @param src where to copy the string from
- * @return char* where the string was copied to
+ * @brief Fill memory with a 32 bit pattern a long at a time, and then the
+ * remaining bytes with the pattern's low byte. Works on every CPU.
  */
-char* strcpy(char* dst, const char* src)
+static void fill_stosl(void* memory, uint32_t pattern, size_t len)
 {
-    char* tmp = dst;
-    while((*dst++ = *src++) != '\0');
-    return tmp;
+    int tmp[2];
+    asm volatile(
+        "rep stosl\n\t"
+        "movl   %5, %%ecx\n\t"
+        "andl   $3, %%ecx\n\t"
+        "rep stosb"
+        : "=D" (tmp[0]), "=c" (tmp[1])
+        : "a" (pattern), "0" (memory), "1" (len / 4), "r" (len)
+        : "memory"
+    );
 }
 
+static void memset_stosl(void* memory, uint8_t value, size_t len)
+{
+    fill_stosl(memory, value * SWAR_ONES, len);
+}
 
 /**
- * @brief Find the start of the first occurence of a given substring within
- * a larger string
- *
- * @param haystack the string to search within
- * @param needle the substring to search for
- * @return const char* pointer to the start of the substring within
- * the larger string
+ * @brief Fill memory with a single rep stosb, for CPUs with ERMS.
  */
-const char* strstr(const char* haystack, const char* needle)
+static void memset_erms(void* memory, uint8_t value, size_t len)
 {
-    size_t nlen = strlen(needle);
-    while (*haystack) {
-        if (*haystack == *needle) {
-            if (strncmp(haystack, needle, nlen) == 0)
-                return haystack;
-        }
-        haystack++;
+    int tmp[2];
+    asm volatile(
+        "rep stosb"
+        : "=D" (tmp[0]), "=c" (tmp[1])
+        : "a" (value), "0" (memory), "1" (len)
+        : "memory"
+    );
+}
+
+/**
+ * @brief Fill memory with a 32 bit pattern using SSE2 non-temporal stores,
+ * bypassing the cache. The pattern stays in step only if the memory is long
+ * aligned, or every byte of the pattern is the same.
+ */
+static void fill_movnti(void* memory, uint32_t pattern, size_t len)
+{
+    // as with memcpy_movnti, a fill which doesn't reach the next cache line is
+    // done entirely by the head
+    size_t head = MIN(-(uintptr_t)memory & 0x3f, len);
+    fill_stosl(memory, pattern, head);
+    memory += head;
+    len -= head;
+
+    if (len >= 64) {
+        int tmp[2];
+        asm volatile(
+            "1:\n\t"
+            "movnti %%eax,  0(%%edi)\n\t"
+            "movnti %%eax,  4(%%edi)\n\t"
+            "movnti %%eax,  8(%%edi)\n\t"
+            "movnti %%eax, 12(%%edi)\n\t"
+            "movnti %%eax, 16(%%edi)\n\t"
+            "movnti %%eax, 20(%%edi)\n\t"
+            "movnti %%eax, 24(%%edi)\n\t"
+            "movnti %%eax, 28(%%edi)\n\t"
+            "movnti %%eax, 32(%%edi)\n\t"
+            "movnti %%eax, 36(%%edi)\n\t"
+            "movnti %%eax, 40(%%edi)\n\t"
+            "movnti %%eax, 44(%%edi)\n\t"
+            "movnti %%eax, 48(%%edi)\n\t"
+            "movnti %%eax, 52(%%edi)\n\t"
+            "movnti %%eax, 56(%%edi)\n\t"
+            "movnti %%eax, 60(%%edi)\n\t"
+            "add $64, %%edi\n\t"
+            "dec %%ecx\n\t"
+            "jnz 1b\n\t"
+            "sfence"
+            : "=D" (tmp[0]), "=c" (tmp[1])
+            : "a" (pattern), "0" (memory), "1" (len >> 6)
+            : "memory"
+        );
     }
-    return NULL;
+
+    size_t filled = len & ~0x3f;
+    fill_stosl(memory + filled, pattern, len - filled);
+}
+
+static void memset_movnti(void* memory, uint8_t value, size_t len)
+{
+    fill_movnti(memory, value * SWAR_ONES, len);
+}
+
+static void memops_add_impl(const char* name,
+        void (*copy)(void*, const void*, size_t),
+        void (*fill)(void*, uint8_t, size_t))
+{
+    memops_impls[memops_num_impls].name = name;
+    memops_impls[memops_num_impls].copy = copy;
+    memops_impls[memops_num_impls].fill = fill;
+    memops_num_impls++;
+}
+
+/**
+ * @brief Pick the fastest variants of the memory operations that this CPU
+ * supports. Should be called once, early in boot.
+ */
+void memops_init()
+{
+    int erms = cpuid_check_feature("erms") > 0;
+    int mmx = cpuid_check_feature("mmx") > 0;
+    // we also need SSE for prefetchnta and sfence, but any CPU with SSE2 has
+    // that too
+    int sse2 = cpuid_check_feature("sse2") > 0;
+
+    if (erms) {
+        memcpy_bulk = memcpy_erms;
+        memset_bulk = memset_erms;
+        memops_variant = "erms";
+    } else if (mmx) {
+        memcpy_bulk = memcpy_mmx;
+        memops_variant = "mmx";
+    }
+
+    if (sse2) {
+        memcpy_nt = memcpy_movnti;
+        fill_nt = fill_movnti;
+        memops_nt_threshold = MEMOPS_NT_THRESHOLD;
+    } else {
+        memcpy_nt = memcpy_bulk;
+    }
+
+    memops_num_impls = 1;
+    if (erms)
+        memops_add_impl("erms", memcpy_erms, memset_erms);
+    if (mmx)
+        memops_add_impl("mmx", memcpy_mmx, NULL);
+    if (sse2)
+        memops_add_impl("movnti", memcpy_movnti, memset_movnti);
 }
 
 /**
- * @brief Return a pointer to the first instance of `c` within `s`. If no such
- * instance exists, returns NULL.
+ * @brief Get the variants of memcpy and memset this CPU supports. These work
+ * on any size or alignment, but are otherwise only meant for benchmarking.
  *
- * @param s the string to search for the character in
- * @param c the character to search for
- * @return const char* pointer to the character if it exists; NULL otherwise.
+ * @param impls set to point to the variants
+ * @return int the number of variants
  */
-char* strchr(const char* s, int c)
+int memops_get_impls(const struct memops_impl** impls)
 {
-    do {
-        if (*s == c)
-            return (char*)s;
-    } while (*s++);
-    return NULL;
+    *impls = memops_impls;
+    return memops_num_impls;
 }
 
 /**
- * @brief Return a pointer to a new string, having the contents os the given
- * string. Memory for the string is obtained with `kalloc`.
+ * @brief Get a short description of the memory operation variants in use
  *
- * @param s the string to duplicate
- * @return pointer to the newly duplicated string
+ * @return const char* the description, e.g. "erms+movnti"
  */
-char* strdup(const char* s)
+const char* memops_describe()
 {
-    size_t size = strlen(s) + 1;
-    char* str = kalloc(size);
-    if (str)
-        memcpy(str, s, size);
-    return str;
+    if (memops_nt_threshold == ~(size_t)0)
+        return memops_variant;
+
+    static char desc[16];
+    strcpy(desc, memops_variant);
+    strcat(desc, "+movnti");
+    return desc;
 }
 
 /**
@@ -573,20 +482,56 @@ char* strdup(const char* s)
  */
 void memset(void* memory, uint8_t value, size_t len)
 {
-#ifdef FAST_MEMOPS
-    asm volatile(
-        "rep stosb"
-        :
-        : "a" (value), "D" (memory), "c" (len)
-        : "memory"
-    );
-#else
-    uint8_t* ptr = memory;
-    for (int i = 0; i < len; i++) {
-        ptr[i] = value;
+    if (len < MEMOPS_SMALL)
+        memset_stosl(memory, value, len);
+    else if (len < memops_nt_threshold)
+        memset_bulk(memory, value, len);
+    else
+        fill_nt(memory, value * SWAR_ONES, len);
+}
+
+/**
+ * @brief Fill a region of memory with a 16 bit value
+ *
+ * @param memory a pointer to the start of the memory to fill, which should be
+ * 2 byte aligned
+ * @param value the value to fill with
+ * @param count the number of 16 bit values to fill
+ */
+void memset16(void* memory, uint16_t value, size_t count)
+{
+    uint16_t* ptr = memory;
+
+    // get to a long boundary, and then fill two values at a time
+    if (count && !SWAR_ALIGNED(ptr)) {
+        *ptr++ = value;
+        count--;
     }
-#endif
+
+    memset32(ptr, value * 0x00010001u, count / 2);
+    if (count & 1)
+        ptr[count - 1] = value;
 }
+EXPORT_SYM(memset16);
+
+/**
+ * @brief Fill a region of memory with a 32 bit value. Large fills bypass the
+ * cache where the CPU supports it.
+ *
+ * @param memory a pointer to the start of the memory to fill, which should be
+ * 4 byte aligned
+ * @param value the value to fill with
+ * @param count the number of 32 bit values to fill
+ */
+void memset32(void* memory, uint32_t value, size_t count)
+{
+    size_t len = count * 4;
+    if (len >= memops_nt_threshold && SWAR_ALIGNED(memory))
+        fill_nt(memory, value, len);
+    else
+        fill_stosl(memory, value, len);
+}
+EXPORT_SYM(memset32);
 
 
 /**
@@ -631,74 +576,69 @@ void memblit(void* dst, const void* src,
  */
 void memcpy(void* dst, const void* src, size_t len)
 {
-#ifdef FAST_MEMOPS
-    if (len > 128) {
-        int tmp[3];
-        asm volatile(
-            "loop1:\n\t"
-            "prefetchnta 64(%%esi)\n\t"
-            "prefetchnta 96(%%esi)\n\t"
-
-            "movq  0(%%esi), %%mm1\n\t"
-            "movq  8(%%esi), %%mm2\n\t"
-            "movq 16(%%esi), %%mm3\n\t"
-            "movq 24(%%esi), %%mm4\n\t"
-            "movq 32(%%esi), %%mm5\n\t"
-            "movq 40(%%esi), %%mm6\n\t"
-            "movq 48(%%esi), %%mm7\n\t"
-            "movq 56(%%esi), %%mm0\n\t"
-
-            "movntq %%mm1,  0(%%edi)\n\t"
-            "movntq %%mm2,  8(%%edi)\n\t"
-            "movntq %%mm3, 16(%%edi)\n\t"
-            "movntq %%mm4, 24(%%edi)\n\t"
-            "movntq %%mm5, 32(%%edi)\n\t"
-            "movntq %%mm6, 40(%%edi)\n\t"
-            "movntq %%mm7, 48(%%edi)\n\t"
-            "movntq %%mm0, 56(%%edi)\n\t"
-
-            "add $64, %%esi\n\t"
-            "add $64, %%edi\n\t"
-            "dec %%ecx\n\t"
-            "jnz loop1\n\t"
+    if (len < MEMOPS_SMALL)
+        memcpy_movsl(dst, src, len);
+    else if (len < memops_nt_threshold)
+        memcpy_bulk(dst, src, len);
+    else
+        memcpy_nt(dst, src, len);
+}
 
-            "emms\n\t"
-            : "=S" (tmp[0]), "=D" (tmp[1]), "=c" (tmp[2])
-            : "S" (src), "D" (dst), "c" (len >> 6)
-            : "memory"
-        );
-        size_t copied = len & ~0x3f;
-        len -= copied;
-        src += copied;
-        dst += copied;
+/**
+ * @brief Copy one region of memory to another, where the regions may overlap
+ *
+ * @param dst the destination to copy memory to
+ * @param src the area to copy memory from
+ * @param len the amount (in bytes) of memory to copy
+ */
+void memmove(void* dst, const void* src, size_t len)
+{
+    // every memcpy variant copies from start to end, reading each block before
+    // writing it, which is safe unless the destination starts inside the source
+    if (dst <= src || dst >= src + len) {
+        memcpy(dst, src, len);
+        return;
     }
 
+    // otherwise copy from end to start: the odd bytes at the end, and then
+    // whole longs
+    int tmp[3];
     asm volatile(
-        "rep movsl\n\t"         // move as much as we can long-sized
-        "movl   %3, %%ecx\n\t"  // get the rest of the length
-        "andl   $3, %%ecx\n\t"
-        "jz     1f\n\t"         // perfectly long aligned? done if so
+        "std\n\t"
         "rep movsb\n\t"
-        "1:"
-        :
-        : "S" (src), "D" (dst), "c" (len / 4), "r" (len)
+        "subl   $3, %%esi\n\t"    // point at the start of the last long
+        "subl   $3, %%edi\n\t"
+        "movl   %6, %%ecx\n\t"
+        "rep movsl\n\t"
+        "cld"
+        : "=S" (tmp[0]), "=D" (tmp[1]), "=c" (tmp[2])
+        : "0" (src + len - 1), "1" (dst + len - 1), "2" (len & 3), "r" (len / 4)
         : "memory"
     );
-#else
-    const char* csrc = src;
-    char* cdst = dst;
-    while (len > 0) {
-        *cdst++ = *csrc++;
-        len--;
-    }
-#endif
 }
+EXPORT_SYM(memmove);
 
+/**
+ * @brief Compare two regions of memory
+ *
+ * @param a the first region
+ * @param b the second region
+ * @param len the amount (in bytes) of memory to compare
+ * @return int zero if equal, otherwise the difference between the first pair
+ * of bytes which differ
+ */
 int memcmp(const void* a, const void* b, size_t len)
 {
     const uint8_t* la = a;
     const uint8_t* lb = b;
 
+    // skip over the equal part a long at a time, then find the exact byte
+    while (len >= 4 && *(const uint32_t*)la == *(const uint32_t*)lb) {
+        la += 4;
+        lb += 4;
+        len -= 4;
+    }
+
     for (size_t i = 0; i < len; i++) {
         if (la[i] != lb[i])
             return la[i] - lb[i];
@@ -5,6 +5,14 @@
 #include "kernel.h"
 #include "io/chardev.h"
 
+// A variant of memcpy and memset. fill may be NULL if there is no memset
+// variant to go with the memcpy one
+struct memops_impl {
+    const char* name;
+    void (*copy)(void* dst, const void* src, size_t len);
+    void (*fill)(void* memory, uint8_t value, size_t len);
+};
+
 // Standard library - ish functions
 void itoa(int value, char* buffer, int base);
 int atoi(const char* str);
@@ -18,6 +26,7 @@ unsigned long strtoul(const char* nptr, char** endptr, int base);
 void gets(char* str);
 char getc();
 void puts(const char* str);
+void putsn(const char* str, size_t len);
 void putc(char c);
 int strcmp(const char* a, const char* b);
 char* strcpy(char* dst, const char* src);
@@ -31,8 +40,14 @@ int stricmp(const char* a, const char* b);
 void strcat(char* dst, const char* src);
 int tolower(int ch);
 char* strdup(const char* s);
+void memops_init();
+const char* memops_describe();
+int memops_get_impls(const struct memops_impl** impls);
 void memset(void* memory, uint8_t value, size_t len);
+void memset16(void* memory, uint16_t value, size_t count);
+void memset32(void* memory, uint32_t value, size_t count);
 void memcpy(void* dst, const void* src, size_t len);
+void memmove(void* dst, const void* src, size_t len);
 int memcmp(const void* a, const void* b, size_t len);
 void memblit(void* dst, const void* src,
                     size_t bufwidth, size_t bufheight, size_t elsize,
@@ -82,7 +97,3 @@ void _debug_printf(enum log_level level, const char* file, int line, const char*
 #define logf(l, x, ...)     _debug_printf(l, __FILE__, __LINE__, __PRETTY_FUNCTION__, x, __VA_ARGS__);
 #define debug(x)            _debug_printf(LOG_DEBUG, __FILE__, __LINE__, __PRETTY_FUNCTION__, x);
 #define debugf(x, ...)      _debug_printf(LOG_DEBUG, __FILE__, __LINE__, __PRETTY_FUNCTION__, x, __VA_ARGS__);
-
-// use hand-optimised memory operations (e.g. memcpy, memset, etc.)
-#define FAST_MEMOPS
-
@@ -0,0 +1,558 @@
+/**
+ * @file string.c
+ * @brief String handling and conversion routines
+ *
+ * These are plain C with no dependencies on the hardware, so they can also be
+ * built for the host and tested there.
+ */
+
+#include "stdlib.h"
+#include "alloc.h"
+#include "swar.h"
+
+void swap(char* x, char* y)
+{
+    char temp = *x;
+    *x = *y;
+    *y = temp;
+}
+
+void reverse(char* buffer, int i, int j)
+{
+    while (i < j)
+        swap(&buffer[i++], &buffer[j--]);
+}
+
+/**
+ * @brief Convert an integer to an ascii value
+ *
+ * @param value the integer value
+ * @param buffer the buffer to place the result in
+ * @param base the base to output the number in
+ */
+void itoa(int value, char* buffer, int base)
+{
+    if (base < 2 || base > 32)
+        return;
+
+    int n = value < 0 ? -value : value;
+
+    int i = 0;
+    while (n) {
+        int rem = n % base;
+        if (rem >= 10)
+            buffer[i++] = 'A' + (rem - 10);
+        else
+            buffer[i++] = '0' + rem;
+        n /= base;
+    }
+
+    if (i == 0)
+        buffer[i++] = '0';
+
+    if (value < 0 && base == 10)
+        buffer[i++] = '-';
+
+    buffer[i] = '\0';
+
+    reverse(buffer, 0, i - 1);
+}
+
+/**
+ * @brief Convert an ASCII string which is a base 10 number into its integer
+ * representation. If the string contains non-digit characters, the behaviour
+ * is undefined.
+ *
+ * @param str the string to convert
+ * @return int the integer result
+ */
+int atoi(const char* str)
+{
+    int n = 0;
+    int neg_flag = 0;
+
+    switch (*str) {
+        case '-': neg_flag = 1;
+        case '+': str++;
+    }
+
+    while (*str != '\0')
+        n = 10 * n - (*str++ - '0');
+
+    return neg_flag ? n : -n;
+}
+
+/**
+ * @brief Determine if a character is a space.
+ *
+ * @param c the character to check
+ * @return int non-zero if the character is a space
+ */
+int isspace(int c)
+{
+    return (c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+        c == '\r' || c == ' ') ? 1 : 0;
+}
+
+/**
+ * @brief Determine if a character is a blank.
+ *
+ * @param c the character to check
+ * @return int non-zero if the character is a space or tab
+ */
+int isblank(int c)
+{
+    return (c == '\t' || c == ' ') ? 1 : 0;
+}
+
+/**
+ * @brief Determine if a character is a digit, 0 through 9.
+ *
+ * @param c the character to check
+ * @return int non-zero if the character is a digit
+ */
+int isdigit(int c)
+{
+    return (c >= '0' && c <= '9') ? 1 : 0;
+}
+
+/**
+ * @brief Determine if a character is an alphabetic character, either
+ * lower or upper case.
+ *
+ * @param c the character to check
+ * @return int non-zero if the character is an alphabetic character
+ */
+int isalpha(int c)
+{
+    return ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) ? 1 : 0;
+}
+
+/**
+ * @brief Determine if a character is upper case.
+ *
+ * @param c the character to check
+ * @return int non-zero if the character is upper case
+ */
+int isupper(int c)
+{
+    return (c >= 'A' && c <= 'Z') ? 1 : 0;
+}
+
+/**
+ * @brief Determine if a character is lower case.
+ *
+ * @param c the character to check
+ * @return int non-zero if the character is lower case
+ */
+int islower(int c)
+{
+    return (c > 'a' && c < 'z') ? 1 : 0;
+}
+
+/**
+ * @brief Convert the first numeric part of the string nptr to the given
+ * base, or try to determine the base.
+ *
+ * @param nptr the string which contains the numeric to convert
+ * @param endptr if non-NULL then a pointer to the character following the
+ *               last character of the number
+ * @param base the base of the number to convert, between 2 to 36 specifies
+ *             explicitly the base to convert to. 0 indicates the base is
+ *             detected from the given string
+ * @return unsigned long the converted value
+ */
+unsigned long strtoul(const char* nptr, char** endptr, int base)
+{
+    int neg = 0;
+
+    // skip whitespace
+    const char* p = nptr;
+    while (isspace(*p)) {
+        p++;
+    }
+
+    // do we have a sign?
+    if (*p == '-') {
+        neg = 1;
+        p++;
+    } else if (*p == '+') {
+        p++;
+    }
+
+    // is this hex?
+    char next = *(p + 1);
+    if ((base == 0 || base == 16) && *p == '0' && (next == 'x'  || next == 'X')) {
+        p += 2;
+        base = 16;
+    }
+    // octal or decimal
+    if (base == 0) {
+        base = *p == '0' ? 8 : 10;
+    }
+
+    unsigned long acc = 0;
+    unsigned long cutoff = 0xfffffffful / (unsigned long)base;
+    unsigned long cutlim = 0xfffffffful % (unsigned long)base;
+    int any = 0;
+    for (;; p++) {
+        int c = *p;
+        if (isdigit(c)) {
+            c -= '0';
+        } else if (isalpha(c)) {
+            c -= isupper(c) ? 'A' - 10 : 'a' - 10;
+        } else {
+            break;
+        }
+
+        if (c >= base) {
+            break;
+        }
+        if (any < 0 || acc > cutoff || (acc == cutoff && c > cutlim)) {
+            any = -1;
+        } else {
+            any = 1;
+            acc *= base;
+            acc += c;
+        }
+    }
+    if (any < 0) {
+        acc = 0xfffffffful;
+    } else if (neg) {
+        acc = -acc;
+    }
+    if (endptr != 0) {
+        *endptr = (char*)(any ? p : nptr);
+    }
+    return acc;
+}
+
+/**
+ * @brief Tokenise a string reentrantly
+ *
+ * @param str pointer to the string, may be null on subsequent calls
+ * @param delim a string containing all possible delimiters
+ * @param saveptr used to save the internal state of the strtok_r function across
+ *                multiple calls
+ * @return char* the pointer to the next token
+ */
+// Based on the PDCLib version of strtok
+char* strtok_r(char* str, const char* delim, char** saveptr)
+{
+    if (str != NULL) {
+        // new string
+        *saveptr = str;
+    } else {
+        if (*saveptr == NULL) {
+            // stuck! no new string, nor any old string
+            return NULL;
+        }
+        str = *saveptr;
+    }
+
+    const char* p = delim;
+    while (*p && *str) {
+        if (*str == *p) {
+            // found delim
+            str++;
+            p = delim;
+            continue;
+        }
+
+        p++;
+    }
+
+    if (!*str) {
+        // nothing left
+        *saveptr = str;
+        return NULL;
+    }
+
+    // skip non-delim chrs
+    *saveptr = str;
+
+    while (**saveptr) {
+        p = delim;
+        while (*p) {
+            if (**saveptr == *p++) {
+                // found delim
+                *((*saveptr)++) = '\0';
+                return str;
+            }
+        }
+
+        (*saveptr)++;
+    }
+
+    return str;
+}
+
+/**
+ * @brief Tokenise a string
+ *
+ * @param str pointer to the string, may be null on subsequent calls
+ * @param delim a string containing all possible delimiters
+ * @return char* the pointer to the next token
+ */
+char* strtok(char* str, const char* delim)
+{
+    static char* saveptr;
+    return strtok_r(str, delim, &saveptr);
+}
+
+/**
+ * @brief Determine the length of a given string
+ *
+ * @param str the string
+ * @return size_t the length of the string
+ */
+size_t strlen(const char* str)
+{
+    const char* start = str;
+    while (!SWAR_ALIGNED(str)) {
+        if (!*str)
+            return str - start;
+        str++;
+    }
+
+    while (!SWAR_HAS_ZERO(SWAR_WORD(str)))
+        str += 4;
+
+    while (*str)
+        str++;
+    return str - start;
+}
+
+/**
+ * @brief Concatenate two strings together
+ *
+ * @param dst the destination
+ * @param src the source
+ */
+void strcat(char* dst, const char* src)
+{
+    while (*dst)
+        dst++;
+
+    // Note: assignment _not_ equals, copies until *src == '\0'
+    while ((*dst++ = *src++));
+}
+
+/**
+ * @brief Compare two strings. A non-zero return value indicates that the strings
+ * differ in at least one location
+ *
+ * @param a the first string
+ * @param b the second string
+ * @return int zero if identical, non-zero otherwise
+ */
+int strcmp(const char* a, const char* b)
+{
+    while (!SWAR_ALIGNED(a)) {
+        if (!*a || *a != *b)
+            goto differ;
+        a++; b++;
+    }
+
+    // a is aligned now, b may not be
+    while (SWAR_LOAD_SAFE(b)) {
+        uint32_t wa = SWAR_WORD(a);
+        if (wa != SWAR_WORD(b) || SWAR_HAS_ZERO(wa))
+            break;
+        a += 4; b += 4;
+    }
+
+    while (*a && (*a == *b)) {
+        a++; b++;
+    }
+differ:
+    return *(const unsigned char*)a - *(const unsigned char*)b;
+}
+
+/**
+ * @brief Convert each of the four characters in a word to lowercase, as
+ * tolower would
+ *
+ * @param x the characters
+ * @return uint32_t the lowercase characters
+ */
+static uint32_t tolower_word(uint32_t x)
+{
+    // with the high bit of each byte out of the way, adding to every byte at
+    // once can't carry into the next. The high bits of the sums then tell us
+    // which bytes are past 'Z', and which are at least 'A'
+    uint32_t heptets = x & ~SWAR_HIGHS;
+    uint32_t above_z = heptets + (0x7f - 'Z') * SWAR_ONES;
+    uint32_t from_a = heptets + (0x80 - 'A') * SWAR_ONES;
+    uint32_t upper = (from_a ^ above_z) & ~x & SWAR_HIGHS;
+    return x | (upper >> 2);
+}
+
+/**
+ * @Brief Compare two strings without regard for the case of the characters. A
+ * non-zero return value indicates that the strings differn in at least one
+ * location
+ *
+ * @param a the first string
+ * @param b the second string
+ * @return int zero if identical (apart from case), non-zero otherwise
+ */
+int stricmp(const char* a, const char* b)
+{
+    while (!SWAR_ALIGNED(a)) {
+        if (!*a || tolower((unsigned char)*a) != tolower((unsigned char)*b))
+            goto differ;
+        a++; b++;
+    }
+
+    while (SWAR_LOAD_SAFE(b)) {
+        uint32_t wa = SWAR_WORD(a);
+        if (SWAR_HAS_ZERO(wa) || tolower_word(wa) != tolower_word(SWAR_WORD(b)))
+            break;
+        a += 4; b += 4;
+    }
+
+    while (*a && (tolower((unsigned char)*a) == tolower((unsigned char)*b))) {
+        a++; b++;
+    }
+differ:
+    return (unsigned char)*a - (unsigned char)*b;
+}
+
+/**
+ * @brief Convert a character to lowercase. If the character is not a letter, or
+ * is already lowercase, it will be returned as-is
+ *
+ * @param ch the character to make lowercase
+ * @return int the lowercase character
+ */
+int tolower(int ch)
+{
+    if (ch >= 'A' && ch <= 'Z')
+        return ch ^ 0x20;
+    else
+        return ch;
+}
+
+/**
+ * @brief Compare two strings for a given number of characters
+ *
+ * @param a the first string
+ * @param b the second string
+ * @param n the number of characters to compare
+ * @return int zero if identical for all indicated characters, non-zero otherwise
+ */
+int strncmp(const char* a, const char* b, size_t n)
+{
+    while (n && !SWAR_ALIGNED(a)) {
+        if (!*a || *a != *b)
+            goto differ;
+        ++a;
+        ++b;
+        --n;
+    }
+
+    while (n >= 4 && SWAR_LOAD_SAFE(b)) {
+        uint32_t wa = SWAR_WORD(a);
+        if (wa != SWAR_WORD(b) || SWAR_HAS_ZERO(wa))
+            break;
+        a += 4;
+        b += 4;
+        n -= 4;
+    }
+
+    while (n && *a && (*a == *b)){
+        ++a;
+        ++b;
+        --n;
+    }
+
+    if (n == 0)
+        return 0;
+differ:
+    return (*(const unsigned char *)a - *(unsigned char *)b);
+}
+
+/**
+ * @brief Copy a string to the location pointed to by dst
+ *
+ * @param dst where to copy the string to
+ * @param src where to copy the string from
+ * @return char* where the string was copied to
+ */
+char* strcpy(char* dst, const char* src)
+{
+    char* tmp = dst;
+    while((*dst++ = *src++) != '\0');
+    return tmp;
+}
+
+
+/**
+ * @brief Find the start of the first occurence of a given substring within
+ * a larger string
+ *
+ * @param haystack the string to search within
+ * @param needle the substring to search for
+ * @return const char* pointer to the start of the substring within
+ * the larger string
+ */
+const char* strstr(const char* haystack, const char* needle)
+{
+    size_t nlen = strlen(needle);
+    while (*haystack) {
+        if (*haystack == *needle) {
+            if (strncmp(haystack, needle, nlen) == 0)
+                return haystack;
+        }
+        haystack++;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Return a pointer to the first instance of `c` within `s`. If no such
+ * instance exists, returns NULL.
+ *
+ * @param s the string to search for the character in
+ * @param c the character to search for
+ * @return const char* pointer to the character if it exists; NULL otherwise.
+ */
+char* strchr(const char* s, int c)
+{
+    char ch = c;
+    while (!SWAR_ALIGNED(s)) {
+        if (*s == ch)
+            return (char*)s;
+        if (!*s)
+            return NULL;
+        s++;
+    }
+
+    // skip words which contain neither the terminator nor the character
+    uint32_t pattern = (uint8_t)ch * SWAR_ONES;
+    while (!SWAR_HAS_ZERO(SWAR_WORD(s)) && !SWAR_HAS_ZERO(SWAR_WORD(s) ^ pattern))
+        s += 4;
+
+    do {
+        if (*s == ch)
+            return (char*)s;
+    } while (*s++);
+    return NULL;
+}
+
+/**
+ * @brief Return a pointer to a new string, having the contents os the given
+ * string. Memory for the string is obtained with `kalloc`.
+ *
+ * @param s the string to duplicate
+ * @return pointer to the newly duplicated string
+ */
+char* strdup(const char* s)
+{
+    size_t size = strlen(s) + 1;
+    char* str = kalloc(size);
+    if (str)
+        memcpy(str, s, size);
+    return str;
+}
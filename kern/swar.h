@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Helpers for working on a word (4 bytes) at a time where byte by byte would
+ * be slow. The string routines only load words from addresses which can't
+ * cross into the next page, so they never read anywhere that reading the
+ * string byte by byte wouldn't.
+ */
+#define SWAR_ONES           0x01010101u
+#define SWAR_HIGHS          0x80808080u
+// non-zero if any byte in the word x is zero
+#define SWAR_HAS_ZERO(x)    (((x) - SWAR_ONES) & ~(x) & SWAR_HIGHS)
+// whether a word can be loaded from p without crossing a page boundary
+#define SWAR_LOAD_SAFE(p)   (((uintptr_t)(p) & 0xfff) <= 0xffc)
+#define SWAR_ALIGNED(p)     (((uintptr_t)(p) & 3) == 0)
+#define SWAR_WORD(p)        (*(const uint32_t*)(p))
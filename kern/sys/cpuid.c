@@ -42,6 +42,42 @@ static const char* cpuid_features[] = {
     "pbe"
 };
 
+// structured extended features, from leaf 7 ebx
+static const char* cpuid_ext_features[] = {
+    "fsgsbase",
+    "tsc_adjust",
+    "sgx",
+    "bmi1",
+    "hle",
+    "avx2",
+    "fdp_excptn_only",
+    "smep",
+    "bmi2",
+    "erms",
+    "invpcid",
+    "rtm",
+    "pqm",
+    "fpu_csds_dep",
+    "mpx",
+    "pqe",
+    "avx512f",
+    "avx512dq",
+    "rdseed",
+    "adx",
+    "smap",
+    "avx512ifma",
+    "pcommit",
+    "clflushopt",
+    "clwb",
+    "intel_pt",
+    "avx512pf",
+    "avx512er",
+    "avx512cd",
+    "sha",
+    "avx512bw",
+    "avx512vl"
+};
+
 /**
  * @brief Get the vendor string of this processor
  * 
@@ -61,25 +97,31 @@ void cpuid_get_vendor(char* buf)
 /**
  * @brief Check for a given feature
  * 
- * @param feature the feature to check for (e.g. "mmx")
- * @return int non zero if present, zero if not present
+ * @param feature the feature to check for (e.g. "mmx" or "erms")
+ * @return int non zero if present, zero if not present, -1 if the feature is
+ * unknown
  */
 int cpuid_check_feature(const char* feature)
 {
-    int feature_bit = -1;
+    uint32_t res[4];
+
     for (int i = 0; i < 32; i++) {
         if (strcmp(feature, cpuid_features[i]) == 0) {
-            feature_bit = i;
+            cpuid(1, res);
+            return ((1 << i) & res[3]) != 0;
         }
     }
 
-    if (feature_bit == -1)
-        return -1;
-
-    uint32_t res[4];
-    cpuid(1, res);
+    for (int i = 0; i < 32; i++) {
+        if (strcmp(feature, cpuid_ext_features[i]) == 0) {
+            if (cpuid_get_max_id() < 7)
+                return 0;
+            cpuid(7, res);
+            return ((1 << i) & res[1]) != 0;
+        }
+    }
 
-    return (1 << feature_bit) & res[3];
+    return -1;
 }
 
 /**
@@ -126,6 +168,15 @@ void cpuid_verbose_dump()
             printf("%s ", cpuid_features[i]);
         }
     }
+
+    if (cpuid_get_max_id() >= 7) {
+        cpuid(7, res);
+        for (int i = 0; i < 32; i++) {
+            if (res[1] & (1 << i)) {
+                printf("%s ", cpuid_ext_features[i]);
+            }
+        }
+    }
     printf("\n");
 }
 
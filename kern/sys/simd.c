@@ -0,0 +1,146 @@
+/**
+ * @file simd.c
+ * @brief Opt-in use of the FPU and SSE registers
+ *
+ * The kernel is built without access to the FPU or SSE registers, so normally
+ * the only code which touches them is user programs. When the kernel is built
+ * with KERNEL_SIMD (`make SIMD=1`) and the CPU has SSE2, SSE is enabled at
+ * boot and:
+ *
+ * - every interrupt saves and restores the FPU/SSE state around its handler,
+ *   so whatever was interrupted never sees its registers change
+ * - kernel code may use the registers between kernel_simd_begin and
+ *   kernel_simd_end, which keep the state of any enclosing region or running
+ *   user program safe
+ * - each user program starts with a clean FPU/SSE state, and gets back the
+ *   state of whoever ran it when it exits
+ */
+
+#include "simd.h"
+#include "cpuid.h"
+#include "../stdlib.h"
+
+#define CR0_MP              (1 << 1)
+#define CR0_EM              (1 << 2)
+#define CR0_TS              (1 << 3)
+#define CR0_NE              (1 << 5)
+#define CR4_OSFXSR          (1 << 9)
+#define CR4_OSXMMEXCPT      (1 << 10)
+
+// non-zero once SSE has been enabled. Checked by the interrupt stubs
+uint8_t simd_enabled = 0;
+
+static struct simd_state region_states[SIMD_MAX_DEPTH];
+static int region_depth = 0;
+
+static struct simd_state user_states[SIMD_MAX_DEPTH];
+static int user_depth = 0;
+
+// the state every user program starts with
+static struct simd_state initial_state;
+
+static inline void fxsave(struct simd_state* state)
+{
+    asm volatile("fxsave %0" : "=m" (*state));
+}
+
+static inline void fxrstor(struct simd_state* state)
+{
+    asm volatile("fxrstor %0" : : "m" (*state));
+}
+
+/**
+ * @brief Enable SSE, if the kernel was built to use it and the CPU supports
+ * it. Must be called before interrupts are enabled.
+ */
+void simd_init()
+{
+#ifdef KERNEL_SIMD
+    if (cpuid_check_feature("fxsr") <= 0 || cpuid_check_feature("sse2") <= 0)
+        return;
+
+    uint32_t cr0, cr4;
+    asm volatile("mov %%cr0, %0" : "=r" (cr0));
+    // FPU present (no emulation), no lazy switching, native FPU exceptions
+    cr0 &= ~(CR0_EM | CR0_TS);
+    cr0 |= CR0_MP | CR0_NE;
+    asm volatile("mov %0, %%cr0" : : "r" (cr0));
+
+    asm volatile("mov %%cr4, %0" : "=r" (cr4));
+    cr4 |= CR4_OSFXSR | CR4_OSXMMEXCPT;
+    asm volatile("mov %0, %%cr4" : : "r" (cr4));
+
+    // all exceptions masked, both for x87 and SSE (MXCSR is already 0x1f80)
+    asm volatile("fninit");
+    fxsave(&initial_state);
+
+    simd_enabled = 1;
+#endif
+}
+
+/**
+ * @brief Start a region of kernel code which uses the FPU or SSE registers.
+ * Regions may be nested, and may be used from interrupt handlers.
+ *
+ * @return int non-zero if the registers may be used, in which case
+ * kernel_simd_end must be called at the end of the region. If zero, SIMD isn't
+ * available and the caller should fall back to general purpose registers
+ */
+int kernel_simd_begin()
+{
+    if (!simd_enabled)
+        return 0;
+
+    // take our slot before saving anything, so an interrupt arriving part way
+    // through uses the next one along
+    int depth = region_depth++;
+    ASSERT(depth < SIMD_MAX_DEPTH, "SIMD regions nested too deeply");
+
+    // outside of any region and user program, nobody owns the registers
+    if (depth > 0 || user_depth > 0)
+        fxsave(&region_states[depth]);
+
+    return 1;
+}
+
+/**
+ * @brief End a region started by a successful kernel_simd_begin, restoring
+ * the state from before it.
+ */
+void kernel_simd_end()
+{
+    ASSERT(region_depth > 0, "kernel_simd_end without kernel_simd_begin");
+
+    int depth = region_depth - 1;
+    if (depth > 0 || user_depth > 0)
+        fxrstor(&region_states[depth]);
+
+    region_depth = depth;
+}
+
+/**
+ * @brief Called just before jumping into a user program. Saves the FPU/SSE
+ * state of whatever is running it and gives the program a clean one.
+ */
+void simd_user_enter()
+{
+    if (!simd_enabled)
+        return;
+
+    ASSERT(user_depth < SIMD_MAX_DEPTH, "User programs nested too deeply");
+    fxsave(&user_states[user_depth++]);
+    fxrstor(&initial_state);
+}
+
+/**
+ * @brief Called once a user program has returned. Restores the state saved by
+ * simd_user_enter.
+ */
+void simd_user_exit()
+{
+    if (!simd_enabled)
+        return;
+
+    ASSERT(user_depth > 0, "simd_user_exit without simd_user_enter");
+    fxrstor(&user_states[--user_depth]);
+}
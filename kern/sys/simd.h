@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdint.h>
+
+// Size of the area FXSAVE stores the FPU/SSE state in
+#define SIMD_STATE_SIZE     512
+// How deeply SIMD regions (and user programs) may be nested
+#define SIMD_MAX_DEPTH      4
+
+// Saved FPU/SSE state. FXSAVE requires this to be 16 byte aligned
+struct simd_state {
+    uint8_t data[SIMD_STATE_SIZE];
+} __attribute__((aligned(16)));
+
+extern uint8_t simd_enabled;
+
+void simd_init();
+int kernel_simd_begin();
+void kernel_simd_end();
+void simd_user_enter();
+void simd_user_exit();
@@ -2,4 +2,6 @@
 
 #define NULL            0
 
-typedef unsigned long   size_t;
\ No newline at end of file
+typedef unsigned long   size_t;
+
+#define offsetof(type, member)  __builtin_offsetof(type, member)
@@ -4,6 +4,9 @@
 // Linker symbols
 extern int _kload_addr, _kphys_addr;
 extern int _kend, _kbss_end;
+// Memory map collected by stage2.S
+extern struct e820_entry memory_map[];
+extern uint16_t memory_map_count;
 
 BSCODE static void memcpy(void* dst, const void* src, uint32_t len)
 {
@@ -48,6 +51,11 @@ BSCODE void stage2_hl(struct startup_info* start_info)
     info.free_memory = start_info->extended2;
     info.memory_start = bss_end;
 
+    info.memory_map_entries = memory_map_count;
+    if (info.memory_map_entries > E820_MAX_ENTRIES)
+        info.memory_map_entries = E820_MAX_ENTRIES;
+    memcpy(info.memory_map, memory_map, info.memory_map_entries * sizeof(struct e820_entry));
+
     kernel_main(&info);
 
     asm("cli");
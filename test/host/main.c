@@ -0,0 +1,162 @@
+/**
+ * @file main.c
+ * @brief Runner for the host tests and microbenchmarks
+ *
+ * Usage: hosttest [bench [name]]. With no arguments every unit test is run,
+ * and the exit status is non-zero if any failed. With `bench`, the
+ * microbenchmarks are run instead, or only the one given.
+ */
+
+#include "test.h"
+
+#include <stdarg.h>
+#include <time.h>
+#include "alloc.h"
+
+// memory handed to the kernel's allocator
+#define HOST_HEAP_SIZE      (64 * MiB)
+
+volatile uintptr_t bench_sink;
+
+static int failures;
+static uint32_t rand_state = 1;
+
+struct host_suite {
+    const char* name;
+    void (*test)();
+    void (*bench)();
+};
+
+static struct host_suite suites[] = {
+    {"string", test_string, bench_string},
+    {"htbl", test_htbl, bench_htbl},
+    {"imap", test_imap, bench_imap},
+    {"alloc", test_alloc, bench_alloc},
+    {"list", test_list, bench_list},
+    {"ringbuffer", test_ringbuffer, bench_ringbuffer},
+    {"env", test_env, bench_env},
+    {"cksum", test_cksum, bench_cksum},
+    {"config", test_config, bench_config},
+    {"intern", test_intern, bench_intern},
+};
+
+void test_result(const char* test, const char* reason)
+{
+    if (reason) {
+        printf("[FAIL] %s, reason: %s\n", test, reason);
+        failures++;
+    } else {
+        printf("[OK]   %s\n", test);
+    }
+}
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static size_t total_allocs()
+{
+    struct alloc_stats stats;
+    alloc_get_stats(&stats);
+    return stats.total_allocs;
+}
+
+/**
+ * @brief Start timing a microbenchmark, and counting the allocations it makes.
+ *
+ * @param bench the benchmark
+ * @param name the name to report it under
+ */
+void bench_start(struct bench* bench, const char* name)
+{
+    bench->name = name;
+    bench->start_allocs = total_allocs();
+    bench->start_ns = now_ns();
+}
+
+/**
+ * @brief Finish a microbenchmark and report the time and allocations per
+ * operation.
+ *
+ * @param bench the benchmark
+ * @param ops the number of operations it performed
+ */
+void bench_end(struct bench* bench, size_t ops)
+{
+    uint64_t ns = now_ns() - bench->start_ns;
+    size_t allocs = total_allocs() - bench->start_allocs;
+
+    printf("%-28s %10zu ops %10.1f ns/op %8.3f allocs/op\n",
+        bench->name, ops, (double)ns / ops, (double)allocs / ops);
+}
+
+/**
+ * @brief Get a pseudo-random number, always the same sequence so that runs can
+ * be compared.
+ *
+ * @return uint32_t a random number between 0 and 2^24 - 1
+ */
+uint32_t bench_rand()
+{
+    rand_state = rand_state * 1103515245 + 12345;
+    return rand_state >> 8;
+}
+
+// the few kernel functions the portable code calls, which need something to
+// stand in for them
+void hlt()
+{
+}
+
+uint32_t kticks()
+{
+    return now_ns() / 10000000;
+}
+
+void _assert(const char* expr_str, const char* file, int line, const char* func, int expr, const char* message)
+{
+    if (expr)
+        return;
+
+    fprintf(stderr, "assertion failed: %s (%s)\n    at %s:%d in %s\n", expr_str, message, file, line, func);
+    abort();
+}
+
+void _debug_printf(enum log_level level, const char* file, int line, const char* func, const char* fmt, ...)
+{
+    if (level > LOG_WARN)
+        return;
+
+    va_list va;
+    va_start(va, fmt);
+    fprintf(stderr, "%s: ", func);
+    vfprintf(stderr, fmt, va);
+    fprintf(stderr, "\n");
+    va_end(va);
+}
+
+int main(int argc, char** argv)
+{
+    void* heap = aligned_alloc(4096, HOST_HEAP_SIZE);
+    init_alloc(heap, HOST_HEAP_SIZE);
+
+    int bench = argc >= 2 && strcmp(argv[1], "bench") == 0;
+    const char* only = argc >= 3 ? argv[2] : NULL;
+
+    for (size_t i = 0; i < sizeof(suites) / sizeof(struct host_suite); i++) {
+        if (only && strcmp(only, suites[i].name) != 0)
+            continue;
+
+        if (bench)
+            suites[i].bench();
+        else
+            suites[i].test();
+    }
+
+    if (!bench)
+        printf("%d failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+/*
+ * Stands in for the kernel's kernel.h when building kernel code for the host,
+ * with only the parts that portable code uses.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define KiB             1024
+#define MiB             1048576
+
+enum log_level {
+    LOG_FATAL = 0,
+    LOG_ERROR,
+    LOG_WARN,
+    LOG_INFO,
+    LOG_DEBUG,
+    LOG_ALL
+};
+
+void hlt();
+uint32_t kticks();
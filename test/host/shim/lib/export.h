@@ -0,0 +1,6 @@
+#pragma once
+
+// Nothing is exported from host builds, there's no module loader to use it
+#define EXPORT_SYM(name)
+#define EXPORT_INIT(name)
+#define EXPORT_EARLY_INIT(name)
@@ -0,0 +1,89 @@
+#pragma once
+
+/*
+ * Stands in for the kernel's stdlib.h when building kernel code for the host.
+ *
+ * The C library provides printf and the memory operations. The kernel's own
+ * string routines are renamed with a k prefix, so that they don't replace the
+ * C library's (some of which differ in their return types) for everything
+ * else in the process.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "kernel.h"
+
+#define itoa        kitoa
+#define atoi        katoi
+#define isspace     kisspace
+#define isblank     kisblank
+#define isdigit     kisdigit
+#define isalpha     kisalpha
+#define isupper     kisupper
+#define islower     kislower
+#define strtoul     kstrtoul
+#define strcmp      kstrcmp
+#define strcpy      kstrcpy
+#define strtok      kstrtok
+#define strtok_r    kstrtok_r
+#define strlen      kstrlen
+#define strstr      kstrstr
+#define strchr      kstrchr
+#define strncmp     kstrncmp
+#define stricmp     kstricmp
+#define strcat      kstrcat
+#define tolower     ktolower
+#define strdup      kstrdup
+#define swap        kswap
+#define reverse     kreverse
+
+void itoa(int value, char* buffer, int base);
+int atoi(const char* str);
+int isspace(int c);
+int isblank(int c);
+int isdigit(int c);
+int isalpha(int c);
+int isupper(int c);
+int islower(int c);
+unsigned long strtoul(const char* nptr, char** endptr, int base);
+int strcmp(const char* a, const char* b);
+char* strcpy(char* dst, const char* src);
+char* strtok(char* str, const char* delim);
+char* strtok_r(char* str, const char* delim, char** saveptr);
+size_t strlen(const char* str);
+const char* strstr(const char* haystack, const char* needle);
+char* strchr(const char* s, int c);
+int strncmp(const char* a, const char* b, size_t n);
+int stricmp(const char* a, const char* b);
+void strcat(char* dst, const char* src);
+int tolower(int ch);
+char* strdup(const char* s);
+
+// the kernel's memory operations are mostly assembly, so the C library's are
+// used in their place
+void* memset(void* memory, int value, size_t len);
+void* memcpy(void* dst, const void* src, size_t len);
+void* memmove(void* dst, const void* src, size_t len);
+int memcmp(const void* a, const void* b, size_t len);
+
+#define MAX(a, b) \
+    ({ __typeof__(a) _a = (a); \
+       __typeof__(b) _b = (b); \
+       _a > _b ? _a : _b; })
+
+#define MIN(a, b) \
+    ({ __typeof__(a) _a = (a); \
+       __typeof__(b) _b = (b); \
+       _a < _b ? _a : _b; })
+
+void _assert(const char* expr_str, const char* file, int line, const char* func, int expr, const char* message);
+#define ASSERT(expr, message)       _assert(#expr, __FILE__, __LINE__, __PRETTY_FUNCTION__, expr ? 1 : 0, message);
+
+void _debug_printf(enum log_level level, const char* file, int line, const char* func, const char* fmt, ...);
+
+#define log(l, x)           _debug_printf(l, __FILE__, __LINE__, __PRETTY_FUNCTION__, x);
+#define logf(l, x, ...)     _debug_printf(l, __FILE__, __LINE__, __PRETTY_FUNCTION__, x, __VA_ARGS__);
+#define debug(x)            _debug_printf(LOG_DEBUG, __FILE__, __LINE__, __PRETTY_FUNCTION__, x);
+#define debugf(x, ...)      _debug_printf(LOG_DEBUG, __FILE__, __LINE__, __PRETTY_FUNCTION__, x, __VA_ARGS__);
@@ -0,0 +1,54 @@
+#pragma once
+
+/*
+ * Unit tests and microbenchmarks for the portable parts of the kernel, built
+ * for and run on the host. Tests report their results the same way as the
+ * kernel's selftest command does.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "stdlib.h"
+
+#define TEST_PASS(test) test_result(test, NULL);
+#define TEST_FAIL(test, reason) test_result(test, reason);
+
+void test_result(const char* test, const char* reason);
+
+// A microbenchmark in progress, see bench_start
+struct bench {
+    const char* name;
+    uint64_t start_ns;
+    size_t start_allocs;
+};
+
+void bench_start(struct bench* bench, const char* name);
+void bench_end(struct bench* bench, size_t ops);
+uint32_t bench_rand();
+
+// Stops the compiler from optimising away a result that is otherwise unused
+extern volatile uintptr_t bench_sink;
+
+// Unit tests
+void test_string();
+void test_htbl();
+void test_imap();
+void test_alloc();
+void test_list();
+void test_ringbuffer();
+void test_env();
+void test_cksum();
+void test_config();
+void test_intern();
+
+// Microbenchmarks
+void bench_string();
+void bench_htbl();
+void bench_imap();
+void bench_alloc();
+void bench_list();
+void bench_ringbuffer();
+void bench_env();
+void bench_cksum();
+void bench_config();
+void bench_intern();
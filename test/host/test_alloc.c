@@ -0,0 +1,112 @@
+#include "test.h"
+
+#include "alloc.h"
+
+#define ALLOC_TEST_SLOTS    1000
+
+static void test_alloc_churn()
+{
+    static uint8_t* ptrs[ALLOC_TEST_SLOTS];
+    static size_t sizes[ALLOC_TEST_SLOTS];
+    struct alloc_stats before;
+    alloc_get_stats(&before);
+
+    // random allocations, frees and reallocs, each block filled with its
+    // slot number so that any overlap is noticed
+    for (int i = 0; i < 200000; i++) {
+        int slot = bench_rand() % ALLOC_TEST_SLOTS;
+        if (!ptrs[slot]) {
+            sizes[slot] = bench_rand() % 8 == 0 ? bench_rand() % 20000 + 1 : bench_rand() % 200 + 1;
+            ptrs[slot] = kalloc(sizes[slot]);
+            memset(ptrs[slot], slot, sizes[slot]);
+            continue;
+        }
+
+        for (size_t j = 0; j < sizes[slot]; j++) {
+            if (ptrs[slot][j] != (uint8_t)slot) {
+                TEST_FAIL("alloc: churn", "block overwritten");
+                return;
+            }
+        }
+
+        if (bench_rand() % 4 == 0) {
+            sizes[slot] = bench_rand() % 5000 + 1;
+            ptrs[slot] = krealloc(ptrs[slot], sizes[slot]);
+            memset(ptrs[slot], slot, sizes[slot]);
+        } else {
+            kfree(ptrs[slot]);
+            ptrs[slot] = NULL;
+        }
+    }
+
+    for (int i = 0; i < ALLOC_TEST_SLOTS; i++) {
+        if (ptrs[i])
+            kfree(ptrs[i]);
+        ptrs[i] = NULL;
+    }
+
+    struct alloc_stats after;
+    alloc_get_stats(&after);
+    if (after.live_allocs != before.live_allocs || after.live_bytes != before.live_bytes)
+        TEST_FAIL("alloc: churn", "memory leaked")
+    else
+        TEST_PASS("alloc: churn")
+}
+
+static void test_alloc_aligned()
+{
+    for (size_t align = 16; align <= 4096; align *= 2) {
+        void* ptr = kalloc_aligned(100, align);
+        int misaligned = (uintptr_t)ptr % align != 0;
+        kfree(ptr);
+        if (misaligned) {
+            TEST_FAIL("alloc: aligned", "misaligned allocation");
+            return;
+        }
+    }
+    TEST_PASS("alloc: aligned");
+}
+
+void test_alloc()
+{
+    test_alloc_churn();
+    test_alloc_aligned();
+}
+
+void bench_alloc()
+{
+    struct bench bench;
+    static void* ptrs[ALLOC_TEST_SLOTS];
+
+    bench_start(&bench, "kalloc+kfree (64 bytes)");
+    for (int i = 0; i < 2000000; i++)
+        kfree(kalloc(64));
+    bench_end(&bench, 2000000);
+
+    bench_start(&bench, "kalloc (lifo, 16-271 bytes)");
+    for (int round = 0; round < 500; round++) {
+        for (int i = 0; i < ALLOC_TEST_SLOTS; i++)
+            ptrs[i] = kalloc(16 + i % 256);
+        for (int i = ALLOC_TEST_SLOTS; i > 0; i--)
+            kfree(ptrs[i - 1]);
+    }
+    bench_end(&bench, 500 * ALLOC_TEST_SLOTS);
+    memset(ptrs, 0, sizeof(ptrs));
+
+    bench_start(&bench, "kalloc/kfree (random churn)");
+    for (int i = 0; i < 1000000; i++) {
+        int slot = bench_rand() % ALLOC_TEST_SLOTS;
+        if (ptrs[slot]) {
+            kfree(ptrs[slot]);
+            ptrs[slot] = NULL;
+        } else {
+            ptrs[slot] = kalloc(bench_rand() % 16 == 0 ? bench_rand() % 16384 + 1 : bench_rand() % 512 + 1);
+        }
+    }
+    bench_end(&bench, 1000000);
+
+    for (int i = 0; i < ALLOC_TEST_SLOTS; i++) {
+        if (ptrs[i])
+            kfree(ptrs[i]);
+    }
+}
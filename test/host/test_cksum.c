@@ -0,0 +1,55 @@
+#include "test.h"
+
+#include "cksum.h"
+
+void test_cksum()
+{
+    if (crc32(CRC32_INIT, "123456789", 9) != 0xcbf43926)
+        TEST_FAIL("cksum: crc32", "wrong check value")
+    else if (crc32(crc32(CRC32_INIT, "1234", 4), "56789", 5) != 0xcbf43926)
+        TEST_FAIL("cksum: crc32", "wrong when calculated in pieces")
+    else
+        TEST_PASS("cksum: crc32")
+
+    if (adler32(ADLER32_INIT, "Wikipedia", 9) != 0x11e60398)
+        TEST_FAIL("cksum: adler32", "wrong check value")
+    else
+        TEST_PASS("cksum: adler32")
+
+    const uint8_t ip_header[20] = {
+        0x45, 0x00, 0x00, 0x73, 0x00, 0x00, 0x40, 0x00, 0x40, 0x11,
+        0x00, 0x00, 0xc0, 0xa8, 0x00, 0x01, 0xc0, 0xa8, 0x00, 0xc7
+    };
+    if (cksum_inet(ip_header, sizeof(ip_header)) != 0xb861)
+        TEST_FAIL("cksum: inet", "wrong checksum")
+    else
+        TEST_PASS("cksum: inet")
+}
+
+void bench_cksum()
+{
+    struct bench bench;
+    static uint8_t data[64 * KiB];
+    for (size_t i = 0; i < sizeof(data); i++)
+        data[i] = i * 7;
+
+    bench_start(&bench, "crc32 (64 KiB)");
+    for (int i = 0; i < 2000; i++)
+        bench_sink += crc32(CRC32_INIT, data, sizeof(data));
+    bench_end(&bench, 2000);
+
+    bench_start(&bench, "crc32_bytewise (64 KiB)");
+    for (int i = 0; i < 200; i++)
+        bench_sink += crc32_bytewise(CRC32_INIT, data, sizeof(data));
+    bench_end(&bench, 200);
+
+    bench_start(&bench, "adler32 (64 KiB)");
+    for (int i = 0; i < 2000; i++)
+        bench_sink += adler32(ADLER32_INIT, data, sizeof(data));
+    bench_end(&bench, 2000);
+
+    bench_start(&bench, "cksum_inet (64 KiB)");
+    for (int i = 0; i < 2000; i++)
+        bench_sink += cksum_inet(data, sizeof(data));
+    bench_end(&bench, 2000);
+}
@@ -0,0 +1,95 @@
+#include "test.h"
+
+#include "config.h"
+
+static int watch_calls;
+
+static void count_changes(config_handle_t handle, void* priv)
+{
+    watch_calls++;
+    *(config_handle_t*)priv = handle;
+}
+
+// the tests and benchmarks each need the config system set up, but only once
+static void config_setup()
+{
+    static int done;
+    if (done)
+        return;
+
+    config_init();
+    config_newns("test");
+    done = 1;
+}
+
+static void test_config_values()
+{
+    config_setstr("test:str", "one");
+    config_setstr("test:str", "two");
+    config_setint("test:int", 42);
+    config_setobj("test:obj", &watch_calls);
+
+    if (!config_getstr("test:str") || strcmp(config_getstr("test:str"), "two") != 0)
+        TEST_FAIL("config: values", "wrong string value")
+    else if (config_getint("test:int") != 42 || config_getobj("test:obj") != &watch_calls)
+        TEST_FAIL("config: values", "wrong int or object value")
+    else if (config_getint("test:str") != 0 || config_getstr("test:int") != NULL)
+        TEST_FAIL("config: values", "value read as the wrong type")
+    else if (config_exists("test:missing") || config_gettype("test:int") != CONFIG_TYPE_INT)
+        TEST_FAIL("config: values", "wrong type or existence")
+    else if (config_getstr("nonexistent:key") != NULL || config_lookup("no_namespace"))
+        TEST_FAIL("config: values", "found key in missing namespace")
+    else
+        TEST_PASS("config: values")
+}
+
+static void test_config_handle()
+{
+    config_handle_t changed = NULL;
+
+    // looking up a key that isn't set yet mustn't make it exist
+    config_handle_t handle = config_lookup("test:later");
+    if (!handle || config_exists("test:later") || config_handle_getstr(handle)) {
+        TEST_FAIL("config: handle", "unset key looked set");
+        return;
+    }
+
+    watch_calls = 0;
+    config_watch(handle, count_changes, &changed);
+    config_setstr("test:later", "first");
+    config_setint("test:later", 7);
+
+    if (config_lookup("test:later") != handle)
+        TEST_FAIL("config: handle", "handle changed when value was set")
+    else if (config_handle_gettype(handle) != CONFIG_TYPE_INT || config_handle_getint(handle) != 7)
+        TEST_FAIL("config: handle", "handle doesn't see the current value")
+    else if (watch_calls != 2 || changed != handle)
+        TEST_FAIL("config: handle", "watcher not called for every change")
+    else
+        TEST_PASS("config: handle")
+}
+
+void test_config()
+{
+    config_setup();
+    test_config_values();
+    test_config_handle();
+}
+
+void bench_config()
+{
+    struct bench bench;
+    config_setup();
+    config_setstr("test:def_fs", "hd0p0");
+    config_handle_t handle = config_lookup("test:def_fs");
+
+    bench_start(&bench, "config_getstr");
+    for (int i = 0; i < 1000000; i++)
+        bench_sink += (uintptr_t)config_getstr("test:def_fs");
+    bench_end(&bench, 1000000);
+
+    bench_start(&bench, "config_handle_getstr");
+    for (int i = 0; i < 1000000; i++)
+        bench_sink += (uintptr_t)config_handle_getstr(handle);
+    bench_end(&bench, 1000000);
+}
@@ -0,0 +1,109 @@
+#include "test.h"
+
+#include "env.h"
+
+#define ENV_TEST_KEYS   100
+
+static void test_env_basic()
+{
+    env_t* env = env_init();
+    char kvp[] = "one=1\ntwo=2\n\nthree=3\n";
+    env_kvp_lines_add(env, kvp);
+    env_put(env, "two", "TWO");
+    const char* removed = env_remove(env, "one");
+
+    if (env_get(env, "one", char*) != NULL)
+        TEST_FAIL("env", "removed key still present")
+    else if (!removed || strcmp(removed, "1") != 0)
+        TEST_FAIL("env", "remove didn't return the value")
+    else if (!env_get(env, "two", char*) || strcmp(env_get(env, "two", char*), "TWO") != 0)
+        TEST_FAIL("env", "wrong value after replacing")
+    else if (!env_get(env, "three", char*) || strcmp(env_get(env, "three", char*), "3") != 0)
+        TEST_FAIL("env", "wrong value")
+    else
+        TEST_PASS("env")
+
+    env_destroy(env);
+}
+
+// builds a buffer of `count` lines of `key_N=N`
+static char* make_kvp_lines(int count)
+{
+    char* lines = malloc(count * 64 + 1);
+    char* p = lines;
+    for (int i = 0; i < count; i++)
+        p += sprintf(p, "a_rather_long_variable_name_%d=%d\n", i, i);
+    return lines;
+}
+
+// the old environment was capped at 128 items, with 64 character keys
+static void test_env_large()
+{
+    env_t* env = env_init();
+    char* lines = make_kvp_lines(ENV_TEST_KEYS * 10);
+    char key[64], value[16];
+
+    if (!env_kvp_lines_add(env, lines)) {
+        TEST_FAIL("env: large", "failed to add lines");
+        goto cleanup;
+    }
+
+    for (int i = 0; i < ENV_TEST_KEYS * 10; i++) {
+        snprintf(key, sizeof(key), "a_rather_long_variable_name_%d", i);
+        snprintf(value, sizeof(value), "%d", i);
+        const char* v = env_get(env, key, const char*);
+        if (!v || strcmp(v, value) != 0) {
+            TEST_FAIL("env: large", "wrong value");
+            goto cleanup;
+        }
+    }
+
+    TEST_PASS("env: large");
+
+cleanup:
+    env_destroy(env);
+    free(lines);
+}
+
+void test_env()
+{
+    test_env_basic();
+    test_env_large();
+}
+
+void bench_env()
+{
+    struct bench bench;
+    static char keys[ENV_TEST_KEYS][32];
+    for (int i = 0; i < ENV_TEST_KEYS; i++)
+        snprintf(keys[i], sizeof(keys[i]), "variable_%d", i);
+
+    env_t* env = env_init();
+    bench_start(&bench, "env_put (100 keys)");
+    for (int round = 0; round < 2000; round++) {
+        for (int i = 0; i < ENV_TEST_KEYS; i++)
+            env_put(env, keys[i], keys[i]);
+    }
+    bench_end(&bench, 2000 * ENV_TEST_KEYS);
+
+    bench_start(&bench, "env_get (hit, 100 keys)");
+    for (int i = 0; i < 1000000; i++)
+        bench_sink += (uintptr_t)env_get(env, keys[bench_rand() % ENV_TEST_KEYS], void*);
+    bench_end(&bench, 1000000);
+
+    bench_start(&bench, "env_get (miss, 100 keys)");
+    for (int i = 0; i < 1000000; i++)
+        bench_sink += (uintptr_t)env_get(env, "not_a_variable", void*);
+    bench_end(&bench, 1000000);
+    env_destroy(env);
+
+    bench_start(&bench, "env_kvp_lines_add (1000 lines)");
+    for (int round = 0; round < 200; round++) {
+        char* lines = make_kvp_lines(ENV_TEST_KEYS * 10);
+        env = env_init();
+        env_kvp_lines_add(env, lines);
+        env_destroy(env);
+        free(lines);
+    }
+    bench_end(&bench, 200 * ENV_TEST_KEYS * 10);
+}
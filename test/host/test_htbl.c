@@ -0,0 +1,261 @@
+#include "test.h"
+
+#include "htbl.h"
+#include "alloc.h"
+
+#define HTBL_TEST_KEYS  1000
+
+static void test_htbl_basic()
+{
+    htbl_t* table = htbl_create();
+    htbl_put(table, "foo", "value 1");
+    htbl_put(table, "bar", "value 2");
+    htbl_put(table, "foo", "value 3");
+
+    const char* foo = htbl_get(table, "foo");
+    const char* bar = htbl_get(table, "bar");
+    if (!foo || !bar || strcmp(foo, "value 3") != 0 || strcmp(bar, "value 2") != 0)
+        TEST_FAIL("htbl: put/get", "wrong mapping")
+    else if (htbl_get(table, "baz"))
+        TEST_FAIL("htbl: put/get", "mapping for missing key")
+    else
+        TEST_PASS("htbl: put/get")
+
+    htbl_destroy(table);
+}
+
+static void test_htbl_many()
+{
+    htbl_t* table = htbl_create();
+    char key[32];
+
+    for (uintptr_t i = 0; i < HTBL_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "key_%lu", (unsigned long)i);
+        htbl_put(table, key, (void*)(i + 1));
+    }
+
+    for (uintptr_t i = 0; i < HTBL_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "key_%lu", (unsigned long)i);
+        if (htbl_get(table, key) != (void*)(i + 1)) {
+            TEST_FAIL("htbl: expand", "key mapped to wrong value");
+            htbl_destroy(table);
+            return;
+        }
+    }
+
+    TEST_PASS("htbl: expand");
+    htbl_destroy(table);
+}
+
+// insert and remove keys at random, checking the table against a plain array
+// of which keys should be present after every step
+static void test_htbl_remove()
+{
+    htbl_t* table = htbl_create();
+    static char present[HTBL_TEST_KEYS];
+    size_t count = 0;
+    char key[32];
+
+    memset(present, 0, sizeof(present));
+    for (int step = 0; step < 20000; step++) {
+        uintptr_t i = bench_rand() % HTBL_TEST_KEYS;
+        snprintf(key, sizeof(key), "key_%lu", (unsigned long)i);
+
+        if (bench_rand() % 2) {
+            htbl_put(table, key, (void*)(i + 1));
+            count += !present[i];
+            present[i] = 1;
+        } else {
+            void* expect = present[i] ? (void*)(i + 1) : NULL;
+            if (htbl_remove(table, key) != expect) {
+                TEST_FAIL("htbl: remove", "returned wrong value");
+                goto cleanup;
+            }
+            count -= present[i];
+            present[i] = 0;
+        }
+
+        if (htbl_length(table) != count) {
+            TEST_FAIL("htbl: remove", "wrong length");
+            goto cleanup;
+        }
+    }
+
+    for (uintptr_t i = 0; i < HTBL_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "key_%lu", (unsigned long)i);
+        if (htbl_get(table, key) != (present[i] ? (void*)(i + 1) : NULL)) {
+            TEST_FAIL("htbl: remove", "lost or stale mapping");
+            goto cleanup;
+        }
+    }
+
+    TEST_PASS("htbl: remove");
+
+cleanup:
+    htbl_destroy(table);
+}
+
+static void test_htbl_iterate()
+{
+    htbl_t* table = htbl_create();
+    static char seen[HTBL_TEST_KEYS];
+    char key[32];
+
+    for (uintptr_t i = 0; i < HTBL_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "key_%lu", (unsigned long)i);
+        htbl_put(table, key, (void*)i);
+    }
+
+    // drop every third key, so iteration has to skip the gaps left behind
+    for (uintptr_t i = 0; i < HTBL_TEST_KEYS; i += 3) {
+        snprintf(key, sizeof(key), "key_%lu", (unsigned long)i);
+        htbl_remove(table, key);
+    }
+
+    memset(seen, 0, sizeof(seen));
+    size_t iter = 0, count = 0;
+    const char* k;
+    void* v;
+    while (htbl_next(table, &iter, &k, &v)) {
+        uintptr_t i = (uintptr_t)v;
+        snprintf(key, sizeof(key), "key_%lu", (unsigned long)i);
+        if (i >= HTBL_TEST_KEYS || i % 3 == 0 || seen[i] || strcmp(k, key) != 0) {
+            TEST_FAIL("htbl: iterate", "unexpected mapping");
+            goto cleanup;
+        }
+        seen[i] = 1;
+        count++;
+    }
+
+    if (count != htbl_length(table))
+        TEST_FAIL("htbl: iterate", "missed mappings")
+    else
+        TEST_PASS("htbl: iterate")
+
+cleanup:
+    htbl_destroy(table);
+}
+
+static void test_htbl_borrowed()
+{
+    htbl_t* table = htbl_create_flags(HTBL_BORROW_KEYS);
+    static char keys[HTBL_TEST_KEYS][32];
+
+    for (uintptr_t i = 0; i < HTBL_TEST_KEYS; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "key_%lu", (unsigned long)i);
+        htbl_put(table, keys[i], (void*)(i + 1));
+    }
+
+    // the table should hold the very same keys it was given
+    size_t iter = 0;
+    const char* key;
+    void* value;
+    while (htbl_next(table, &iter, &key, &value)) {
+        if (key != keys[(uintptr_t)value - 1]) {
+            TEST_FAIL("htbl: borrowed keys", "key was copied");
+            goto cleanup;
+        }
+    }
+
+    // removing (and destroying) mustn't free keys it doesn't own, which the
+    // allocator would catch as a bad free
+    for (uintptr_t i = 0; i < HTBL_TEST_KEYS; i += 2)
+        htbl_remove(table, keys[i]);
+
+    if (htbl_length(table) != HTBL_TEST_KEYS / 2 || htbl_get(table, "key_1") != (void*)2)
+        TEST_FAIL("htbl: borrowed keys", "wrong mapping after removal")
+    else
+        TEST_PASS("htbl: borrowed keys")
+
+cleanup:
+    htbl_destroy(table);
+}
+
+// the copies of the keys a table makes are freed again on removal and when
+// the table is destroyed
+static void test_htbl_owned()
+{
+    struct alloc_stats before, after;
+    char key[32];
+
+    alloc_get_stats(&before);
+    htbl_t* table = htbl_create();
+    for (uintptr_t i = 0; i < HTBL_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "owned_%lu", (unsigned long)i);
+        htbl_put(table, key, (void*)i);
+    }
+    for (uintptr_t i = 0; i < HTBL_TEST_KEYS; i += 2) {
+        snprintf(key, sizeof(key), "owned_%lu", (unsigned long)i);
+        htbl_remove(table, key);
+    }
+    htbl_destroy(table);
+    alloc_get_stats(&after);
+
+    if (after.live_allocs != before.live_allocs || after.live_bytes != before.live_bytes)
+        TEST_FAIL("htbl: owned keys", "keys leaked")
+    else
+        TEST_PASS("htbl: owned keys")
+}
+
+void test_htbl()
+{
+    test_htbl_basic();
+    test_htbl_many();
+    test_htbl_remove();
+    test_htbl_iterate();
+    test_htbl_borrowed();
+    test_htbl_owned();
+}
+
+void bench_htbl()
+{
+    struct bench bench;
+    static char keys[HTBL_TEST_KEYS][32];
+    for (int i = 0; i < HTBL_TEST_KEYS; i++)
+        snprintf(keys[i], sizeof(keys[i]), "namespace:key_%d", i);
+
+    bench_start(&bench, "htbl_put (1000 new keys)");
+    htbl_t* table = NULL;
+    for (int round = 0; round < 200; round++) {
+        if (table)
+            htbl_destroy(table);
+        table = htbl_create();
+        for (int i = 0; i < HTBL_TEST_KEYS; i++)
+            htbl_put(table, keys[i], keys[i]);
+    }
+    bench_end(&bench, 200 * HTBL_TEST_KEYS);
+
+    bench_start(&bench, "htbl_put (1000 borrowed keys)");
+    for (int round = 0; round < 200; round++) {
+        htbl_t* borrowed = htbl_create_flags(HTBL_BORROW_KEYS);
+        for (int i = 0; i < HTBL_TEST_KEYS; i++)
+            htbl_put(borrowed, keys[i], keys[i]);
+        htbl_destroy(borrowed);
+    }
+    bench_end(&bench, 200 * HTBL_TEST_KEYS);
+
+    bench_start(&bench, "htbl_put (existing key)");
+    for (int i = 0; i < 2000000; i++)
+        htbl_put(table, keys[i % HTBL_TEST_KEYS], NULL);
+    bench_end(&bench, 2000000);
+
+    bench_start(&bench, "htbl_get (hit)");
+    for (int i = 0; i < 2000000; i++)
+        bench_sink += (uintptr_t)htbl_get(table, keys[bench_rand() % HTBL_TEST_KEYS]);
+    bench_end(&bench, 2000000);
+
+    bench_start(&bench, "htbl_get (miss)");
+    for (int i = 0; i < 2000000; i++)
+        bench_sink += (uintptr_t)htbl_get(table, "not:a_key");
+    bench_end(&bench, 2000000);
+
+    bench_start(&bench, "htbl_remove + htbl_put");
+    for (int i = 0; i < 2000000; i++) {
+        const char* key = keys[bench_rand() % HTBL_TEST_KEYS];
+        bench_sink += (uintptr_t)htbl_remove(table, key);
+        htbl_put(table, key, (void*)key);
+    }
+    bench_end(&bench, 2000000);
+
+    htbl_destroy(table);
+}
@@ -0,0 +1,129 @@
+#include "test.h"
+
+#include "imap.h"
+#include "htbl.h"
+
+#define IMAP_TEST_KEYS  1000
+
+// insert and remove keys at random, checking the map against a plain array of
+// which keys should be present after every step. the keys are spaced out like
+// pointers, so they share their low bits
+static void test_imap_random()
+{
+    imap_t* map = imap_create();
+    static char present[IMAP_TEST_KEYS];
+    size_t count = 0;
+
+    memset(present, 0, sizeof(present));
+    for (int step = 0; step < 20000; step++) {
+        uintptr_t i = bench_rand() % IMAP_TEST_KEYS;
+
+        if (bench_rand() % 2) {
+            imap_put(map, i * 64, (void*)(i + 1));
+            count += !present[i];
+            present[i] = 1;
+        } else {
+            void* expect = present[i] ? (void*)(i + 1) : NULL;
+            if (imap_remove(map, i * 64) != expect) {
+                TEST_FAIL("imap: put/remove", "returned wrong value");
+                goto cleanup;
+            }
+            count -= present[i];
+            present[i] = 0;
+        }
+
+        if (imap_length(map) != count) {
+            TEST_FAIL("imap: put/remove", "wrong length");
+            goto cleanup;
+        }
+    }
+
+    for (uintptr_t i = 0; i < IMAP_TEST_KEYS; i++) {
+        if (imap_get(map, i * 64) != (present[i] ? (void*)(i + 1) : NULL)) {
+            TEST_FAIL("imap: put/remove", "lost or stale mapping");
+            goto cleanup;
+        }
+    }
+
+    TEST_PASS("imap: put/remove");
+
+cleanup:
+    imap_destroy(map);
+}
+
+static void test_imap_keys()
+{
+    imap_t* map = imap_create();
+    int object;
+
+    // zero and the largest key are ordinary keys, and pointers go through the
+    // convenience wrappers
+    imap_put(map, 0, "zero");
+    imap_put(map, UINTPTR_MAX, "max");
+    imap_pput(map, &object, "object");
+
+    size_t iter = 0, count = 0;
+    while (imap_next(map, &iter, NULL, NULL))
+        count++;
+
+    if (strcmp(imap_tget(map, 0, const char*), "zero") != 0
+            || strcmp(imap_tget(map, UINTPTR_MAX, const char*), "max") != 0
+            || strcmp(imap_pget(map, &object), "object") != 0)
+        TEST_FAIL("imap: keys", "wrong mapping")
+    else if (count != 3 || imap_premove(map, &object) == NULL || imap_pget(map, &object))
+        TEST_FAIL("imap: keys", "wrong count or removal")
+    else
+        TEST_PASS("imap: keys")
+
+    imap_destroy(map);
+}
+
+void test_imap()
+{
+    test_imap_random();
+    test_imap_keys();
+}
+
+// compares against formatting the integer into a string for a `htbl`, which is
+// what callers had to do before
+void bench_imap()
+{
+    struct bench bench;
+    imap_t* map = imap_create();
+    htbl_t* table = htbl_create();
+    char key[16];
+
+    bench_start(&bench, "imap_put (1000 new keys)");
+    for (int round = 0; round < 200; round++) {
+        imap_destroy(map);
+        map = imap_create();
+        for (uintptr_t i = 0; i < IMAP_TEST_KEYS; i++)
+            imap_put(map, i, (void*)i);
+    }
+    bench_end(&bench, 200 * IMAP_TEST_KEYS);
+
+    for (uintptr_t i = 0; i < IMAP_TEST_KEYS; i++) {
+        snprintf(key, sizeof(key), "%lu", (unsigned long)i);
+        htbl_put(table, key, (void*)i);
+    }
+
+    bench_start(&bench, "imap_get (hit)");
+    for (int i = 0; i < 2000000; i++)
+        bench_sink += (uintptr_t)imap_get(map, bench_rand() % IMAP_TEST_KEYS);
+    bench_end(&bench, 2000000);
+
+    bench_start(&bench, "htbl_get (hit, formatted key)");
+    for (int i = 0; i < 2000000; i++) {
+        snprintf(key, sizeof(key), "%lu", (unsigned long)(bench_rand() % IMAP_TEST_KEYS));
+        bench_sink += (uintptr_t)htbl_get(table, key);
+    }
+    bench_end(&bench, 2000000);
+
+    bench_start(&bench, "imap_get (miss)");
+    for (int i = 0; i < 2000000; i++)
+        bench_sink += (uintptr_t)imap_get(map, IMAP_TEST_KEYS + bench_rand() % IMAP_TEST_KEYS);
+    bench_end(&bench, 2000000);
+
+    htbl_destroy(table);
+    imap_destroy(map);
+}
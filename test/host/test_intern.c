@@ -0,0 +1,96 @@
+#include "test.h"
+
+#include "intern.h"
+#include "htbl.h"
+
+#define INTERN_TEST_KEYS    1000
+
+static void test_intern_canonical()
+{
+    char a[] = "some:name", b[] = "some:name";
+    const char* ia = intern(a);
+    const char* ib = intern(b);
+
+    if (ia != ib || ia == a || strcmp(ia, "some:name") != 0)
+        TEST_FAIL("intern: canonical", "equal strings interned differently")
+    else if (intern("other:name") == ia)
+        TEST_FAIL("intern: canonical", "different strings interned the same")
+    else if (intern_lookup(b) != ia || intern_lookup("never:interned"))
+        TEST_FAIL("intern: canonical", "wrong lookup")
+    else if (intern_hash(ia) != htbl_hash("some:name"))
+        TEST_FAIL("intern: canonical", "wrong hash")
+    else
+        TEST_PASS("intern: canonical")
+}
+
+// tables created to intern their keys share them, hand back the interned
+// copy, and find interned keys by pointer
+static void test_intern_htbl()
+{
+    htbl_t* t1 = htbl_create_flags(HTBL_INTERN_KEYS);
+    htbl_t* t2 = htbl_create_flags(HTBL_INTERN_KEYS);
+    char key[] = "shared:key";
+    htbl_put(t1, key, "one");
+    htbl_put(t2, key, "two");
+
+    const char* k1 = NULL;
+    const char* k2 = NULL;
+    size_t iter = 0;
+    htbl_next(t1, &iter, &k1, NULL);
+    iter = 0;
+    htbl_next(t2, &iter, &k2, NULL);
+
+    const char* interned = intern_lookup(key);
+    if (k1 != k2 || k1 != interned)
+        TEST_FAIL("intern: htbl keys", "keys not shared")
+    else if (strcmp(htbl_get(t2, key), "two") != 0 || htbl_get(t1, "shared:kez"))
+        TEST_FAIL("intern: htbl keys", "wrong mapping")
+    else if (strcmp(htbl_get_interned(t1, interned), "one") != 0
+            || htbl_get_interned(t1, intern("shared:kez")))
+        TEST_FAIL("intern: htbl keys", "wrong mapping for interned key")
+    else
+        TEST_PASS("intern: htbl keys")
+
+    htbl_destroy(t1);
+    htbl_destroy(t2);
+}
+
+void test_intern()
+{
+    test_intern_canonical();
+    test_intern_htbl();
+}
+
+void bench_intern()
+{
+    struct bench bench;
+    static char keys[INTERN_TEST_KEYS][32];
+    for (int i = 0; i < INTERN_TEST_KEYS; i++)
+        snprintf(keys[i], sizeof(keys[i]), "bench:intern_%d", i);
+
+    for (int i = 0; i < INTERN_TEST_KEYS; i++)
+        intern(keys[i]);
+
+    bench_start(&bench, "intern (existing)");
+    for (int i = 0; i < 2000000; i++)
+        bench_sink += (uintptr_t)intern(keys[bench_rand() % INTERN_TEST_KEYS]);
+    bench_end(&bench, 2000000);
+
+    htbl_t* table = htbl_create_flags(HTBL_INTERN_KEYS);
+    static const char* interned[INTERN_TEST_KEYS];
+    for (int i = 0; i < INTERN_TEST_KEYS; i++) {
+        interned[i] = intern(keys[i]);
+        htbl_put_interned(table, interned[i], keys[i]);
+    }
+
+    bench_start(&bench, "htbl_get_interned (hit)");
+    for (int i = 0; i < 2000000; i++)
+        bench_sink += (uintptr_t)htbl_get_interned(table, interned[bench_rand() % INTERN_TEST_KEYS]);
+    bench_end(&bench, 2000000);
+    htbl_destroy(table);
+
+    bench_start(&bench, "intern_lookup (miss)");
+    for (int i = 0; i < 2000000; i++)
+        bench_sink += (uintptr_t)intern_lookup("bench:not_interned");
+    bench_end(&bench, 2000000);
+}
@@ -0,0 +1,57 @@
+#include "test.h"
+
+#include "list.h"
+
+#define LIST_TEST_ITEMS     1000
+
+void test_list()
+{
+    struct list list;
+    list_init(&list);
+
+    for (uintptr_t i = 0; i < LIST_TEST_ITEMS; i++)
+        list_append(&list, list_node((void*)i));
+
+    // remove every other item, then check what's left is in order
+    int i = 0;
+    struct list_node* node = list_head(&list);
+    while (list_next(node)) {
+        struct list_node* next = list_next(node);
+        if (i++ % 2)
+            list_remove(node);
+        node = next;
+    }
+
+    uintptr_t expected = 0;
+    LIST_FOREACH(item, &list) {
+        if (list_value(item) != (void*)expected) {
+            TEST_FAIL("list", "wrong item");
+            return;
+        }
+        expected += 2;
+    }
+
+    if (expected != LIST_TEST_ITEMS)
+        TEST_FAIL("list", "wrong number of items")
+    else
+        TEST_PASS("list")
+
+    while (list_next(list_head(&list)))
+        list_remove(list_head(&list));
+}
+
+void bench_list()
+{
+    struct bench bench;
+    struct list list;
+    list_init(&list);
+
+    bench_start(&bench, "list_append+list_remove");
+    for (int round = 0; round < 2000; round++) {
+        for (uintptr_t i = 0; i < LIST_TEST_ITEMS; i++)
+            list_append(&list, list_node((void*)i));
+        while (list_next(list_head(&list)))
+            list_remove(list_head(&list));
+    }
+    bench_end(&bench, 2000 * LIST_TEST_ITEMS);
+}
@@ -0,0 +1,49 @@
+#include "test.h"
+
+#include "buffer.h"
+
+void test_ringbuffer()
+{
+    uint8_t space[8];
+    struct ringbuffer rbuf;
+    ringbuffer_init(&rbuf, space, sizeof(space));
+
+    // overfilling it drops the oldest values
+    for (int i = 0; i < 10; i++)
+        ringbuffer_put(&rbuf, i);
+
+    for (int i = 2; i < 10; i++) {
+        if (ringbuffer_empty(&rbuf) || ringbuffer_get(&rbuf) != i) {
+            TEST_FAIL("ringbuffer", "wrong value");
+            return;
+        }
+    }
+
+    if (!ringbuffer_empty(&rbuf)) {
+        TEST_FAIL("ringbuffer", "not empty after reading everything");
+        return;
+    }
+
+    uint32_t in = 0x12345678, out = 0;
+    ringbuffer_put_obj(&rbuf, &in, sizeof(in));
+    ringbuffer_get_obj(&rbuf, &out, sizeof(out));
+    if (in != out)
+        TEST_FAIL("ringbuffer", "object changed")
+    else
+        TEST_PASS("ringbuffer")
+}
+
+void bench_ringbuffer()
+{
+    struct bench bench;
+    uint8_t space[256];
+    struct ringbuffer rbuf;
+    ringbuffer_init(&rbuf, space, sizeof(space));
+
+    bench_start(&bench, "ringbuffer_put+get");
+    for (int i = 0; i < 10000000; i++) {
+        ringbuffer_put(&rbuf, i);
+        bench_sink += ringbuffer_get(&rbuf);
+    }
+    bench_end(&bench, 10000000);
+}
@@ -0,0 +1,188 @@
+#include "test.h"
+
+#include <sys/mman.h>
+#include "alloc.h"
+
+#define PAGE        4096
+
+// byte at a time versions to check the kernel's against
+static size_t ref_strlen(const char* s)
+{
+    size_t n = 0;
+    while (s[n])
+        n++;
+    return n;
+}
+
+static int ref_strncmp(const char* a, const char* b, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] != b[i] || !a[i])
+            return (unsigned char)a[i] - (unsigned char)b[i];
+    }
+    return 0;
+}
+
+static int sign(int x)
+{
+    return (x > 0) - (x < 0);
+}
+
+// a page of memory directly followed by one that can't be touched, so that
+// reading past the end of a string at the end of the page faults
+static char* guarded_page()
+{
+    char* pages = mmap(NULL, PAGE * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    mprotect(pages + PAGE, PAGE, PROT_NONE);
+    return pages;
+}
+
+static void test_compare_random()
+{
+    char* page_a = guarded_page();
+    char* page_b = guarded_page();
+
+    for (int i = 0; i < 200000; i++) {
+        // strings of various lengths and alignments, often ending right at the
+        // guard page
+        size_t len = bench_rand() % 40;
+        char* a = page_a + (bench_rand() % 2 ? PAGE - len - 1 : bench_rand() % 64);
+        char* b = page_b + (bench_rand() % 2 ? PAGE - len - 1 : bench_rand() % 64);
+        for (size_t j = 0; j < len; j++)
+            a[j] = b[j] = 'a' + bench_rand() % 3;
+        a[len] = b[len] = '\0';
+        if (len && bench_rand() % 2)
+            b[bench_rand() % len] = 'a' + bench_rand() % 4;
+
+        if (strlen(a) != ref_strlen(a)) {
+            TEST_FAIL("string: strlen", "wrong length");
+            return;
+        }
+        if (sign(strcmp(a, b)) != sign(ref_strncmp(a, b, len + 1))) {
+            TEST_FAIL("string: strcmp", "wrong result");
+            return;
+        }
+        size_t n = bench_rand() % (len + 2);
+        if (sign(strncmp(a, b, n)) != sign(ref_strncmp(a, b, n))) {
+            TEST_FAIL("string: strncmp", "wrong result");
+            return;
+        }
+        char c = 'a' + bench_rand() % 4;
+        char* expected = NULL;
+        for (size_t j = 0; j < len; j++) {
+            if (a[j] == c) {
+                expected = &a[j];
+                break;
+            }
+        }
+        if (strchr(a, c) != expected) {
+            TEST_FAIL("string: strchr", "wrong result");
+            return;
+        }
+    }
+
+    munmap(page_a, PAGE * 2);
+    munmap(page_b, PAGE * 2);
+    TEST_PASS("string: compare");
+}
+
+static void test_stricmp()
+{
+    if (stricmp("Hello World", "hELLO wORLD") != 0 || stricmp("abc", "abd") == 0
+            || stricmp("@[", "`{") == 0) {
+        TEST_FAIL("string: stricmp", "wrong result");
+        return;
+    }
+    TEST_PASS("string: stricmp");
+}
+
+static void test_strtok()
+{
+    char line[] = "  one two  three ";
+    const char* words[] = { "one", "two", "three" };
+    char* saveptr;
+    int count = 0;
+    for (char* tok = strtok_r(line, " ", &saveptr); tok; tok = strtok_r(NULL, " ", &saveptr)) {
+        if (count >= 3 || strcmp(tok, words[count]) != 0) {
+            TEST_FAIL("string: strtok_r", "wrong token");
+            return;
+        }
+        count++;
+    }
+
+    if (count != 3) {
+        TEST_FAIL("string: strtok_r", "wrong number of tokens");
+        return;
+    }
+    TEST_PASS("string: strtok_r");
+}
+
+static void test_conversions()
+{
+    char buf[32];
+    itoa(-1234, buf, 10);
+    if (strcmp(buf, "-1234") != 0) {
+        TEST_FAIL("string: itoa", "wrong result");
+        return;
+    }
+
+    char* end;
+    if (atoi("42") != 42 || atoi("-17") != -17 || strtoul("0x1f", &end, 0) != 31 || *end
+            || strtoul("777", NULL, 8) != 511) {
+        TEST_FAIL("string: atoi/strtoul", "wrong result");
+        return;
+    }
+    TEST_PASS("string: conversions");
+}
+
+static void test_strdup()
+{
+    char* s = strdup("duplicate me");
+    if (!s || strcmp(s, "duplicate me") != 0)
+        TEST_FAIL("string: strdup", "wrong copy")
+    else
+        TEST_PASS("string: strdup")
+    kfree(s);
+}
+
+void test_string()
+{
+    test_compare_random();
+    test_stricmp();
+    test_strtok();
+    test_conversions();
+    test_strdup();
+}
+
+void bench_string()
+{
+    struct bench bench;
+    char* words[64];
+    for (int i = 0; i < 64; i++) {
+        words[i] = kalloc(64);
+        snprintf(words[i], 64, "some_fairly_long_key_name_%d", i);
+    }
+
+    bench_start(&bench, "strlen (~28 bytes)");
+    for (int i = 0; i < 4000000; i++)
+        bench_sink += strlen(words[i & 63]);
+    bench_end(&bench, 4000000);
+
+    bench_start(&bench, "strcmp (~28 bytes, equal)");
+    for (int i = 0; i < 4000000; i++)
+        bench_sink += strcmp(words[i & 63], words[i & 63]);
+    bench_end(&bench, 4000000);
+
+    bench_start(&bench, "stricmp (~28 bytes, equal)");
+    for (int i = 0; i < 4000000; i++)
+        bench_sink += stricmp(words[i & 63], words[i & 63]);
+    bench_end(&bench, 4000000);
+
+    bench_start(&bench, "strdup+kfree");
+    for (int i = 0; i < 1000000; i++)
+        kfree(strdup(words[i & 63]));
+    bench_end(&bench, 1000000);
+
+    for (int i = 0; i < 64; i++)
+        kfree(words[i]);
+}
@@ -0,0 +1,40 @@
+#!/usr/bin/env python3
+
+import argparse
+import os
+import pathlib
+import struct
+import subprocess
+import tempfile
+import zlib
+
+PT_LOAD = 1
+
+def load_crc(data):
+    # ELF32 header: phoff at 28, phentsize and phnum at 42
+    phoff, = struct.unpack_from('<I', data, 28)
+    phentsize, phnum = struct.unpack_from('<HH', data, 42)
+
+    crc = 0
+    for i in range(phnum):
+        ptype, offset, _, _, filesz = struct.unpack_from('<IIIII', data, phoff + i * phentsize)
+        if ptype == PT_LOAD:
+            crc = zlib.crc32(data[offset:offset + filesz], crc)
+    return crc
+
+def main():
+    parser = argparse.ArgumentParser(description='Add a crc32 section for the loader to verify')
+    parser.add_argument('elf', type=pathlib.Path)
+    args = parser.parse_args()
+
+    crc = load_crc(args.elf.read_bytes())
+    objcopy = os.environ.get('OBJCOPY', 'objcopy')
+
+    with tempfile.NamedTemporaryFile(suffix='.bin') as section:
+        section.write(struct.pack('<I', crc))
+        section.flush()
+        subprocess.run([objcopy, '--remove-section', 'crc32',
+            '--add-section', f'crc32={section.name}', str(args.elf)], check=True)
+
+if __name__ == '__main__':
+    main()